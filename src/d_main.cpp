@@ -136,6 +136,7 @@ void ParseGLDefs();
 // PRIVATE FUNCTION PROTOTYPES ---------------------------------------------
 
 void D_DoomLoop ();
+static void D_BenchLoop (int numtics);
 const char *BaseFileSearch (const char *file, const char *ext, bool lookfirstinprogdir=false);
 
 // EXTERNAL DATA DECLARATIONS ----------------------------------------------
@@ -232,6 +233,8 @@ FStartupInfo DoomStartupInfo;
 FString lastIWAD;
 int restart = 0;
 bool batchrun;	// just run the startup and collect all error messages in a logfile, then quit without any interaction
+bool benchrun;	// run the playsim headless for a fixed number of tics and print timing statistics
+static int benchtics;
 bool AppActive = true;
 
 cycle_t FrameCycles;
@@ -979,6 +982,11 @@ void D_DoomLoop ()
 
 	vid_cursor.Callback();
 
+	if (benchrun)
+	{
+		D_BenchLoop (benchtics);	// never returns
+	}
+
 	for (;;)
 	{
 		try
@@ -1039,6 +1047,126 @@ void D_DoomLoop ()
 	}
 }
 
+//==========================================================================
+//
+// D_BenchLoop
+//
+// Runs the playsim as fast as possible for a fixed number of tics without
+// drawing or presenting anything, then prints a histogram of the time
+// spent per tic and quits. Started with -benchtics <n>, normally together
+// with -playdemo or -warp. Sound is forced to the null backend.
+//
+//==========================================================================
+
+static void D_PrintBenchResults (TArray<uint64_t> &tictimes, uint64_t totaltime)
+{
+	// bucket limits in milliseconds; 28.57 is one tic at TICRATE.
+	static const double bucketlimits[] = { 0.0625, 0.125, 0.25, 0.5, 1, 2, 4, 8, 16, 28.57, 64 };
+	enum { NUM_BUCKETS = countof(bucketlimits) + 1 };
+	unsigned buckets[NUM_BUCKETS] = { 0 };
+	unsigned count = tictimes.Size();
+
+	if (count == 0)
+	{
+		Printf ("benchtics: no tics were run\n");
+		return;
+	}
+
+	for (unsigned i = 0; i < count; i++)
+	{
+		double ms = tictimes[i] / 1e6;
+		unsigned b = 0;
+		while (b < countof(bucketlimits) && ms >= bucketlimits[b]) b++;
+		buckets[b]++;
+	}
+
+	std::sort(&tictimes[0], &tictimes[0] + count);
+	auto percentile = [&](double p) { return tictimes[MIN<unsigned>(count - 1, unsigned(count * p))] / 1e6; };
+
+	Printf (PRINT_LOG, "benchtics: map %s, %u tics in %.3f ms (%.1f tics/sec)\n",
+		level.MapName.GetChars(), count, totaltime / 1e6, count / (totaltime / 1e9));
+	Printf (PRINT_LOG, "  min %.3f  median %.3f  p95 %.3f  p99 %.3f  max %.3f ms\n",
+		tictimes[0] / 1e6, percentile(0.5), percentile(0.95), percentile(0.99), tictimes[count - 1] / 1e6);
+
+	for (unsigned b = 0; b < NUM_BUCKETS; b++)
+	{
+		FString bar;
+		for (unsigned j = (unsigned)(buckets[b] * 50ull / count); j > 0; j--) bar += '#';
+
+		if (b < countof(bucketlimits))
+		{
+			Printf (PRINT_LOG, "  < %8.4f ms: %8u (%5.1f%%) %s\n", bucketlimits[b], buckets[b], buckets[b] * 100. / count, bar.GetChars());
+		}
+		else
+		{
+			Printf (PRINT_LOG, " >= %8.4f ms: %8u (%5.1f%%) %s\n", bucketlimits[b - 1], buckets[b], buckets[b] * 100. / count, bar.GetChars());
+		}
+	}
+}
+
+static void D_BenchLoop (int numtics)
+{
+	TArray<uint64_t> tictimes;
+	uint64_t totaltime = 0;
+	bool inlevel = false;
+
+	tictimes.Reserve(numtics);
+	tictimes.Clear();
+	r_NoInterpolate = true;
+
+	while (tictimes.Size() < (unsigned)numtics)
+	{
+		try
+		{
+			G_BuildTiccmd (&netcmds[consoleplayer][maketic%BACKUPTICS]);
+			if (advancedemo)
+				D_DoAdvanceDemo ();
+
+			uint64_t start = I_nsTime();
+			G_Ticker ();
+			uint64_t elapsed = I_nsTime() - start;
+
+			gametic++;
+			maketic++;
+			GC::CheckGC ();
+			Net_NewMakeTic ();
+
+			// Only tics that actually ran the level count; the one that
+			// loads the map would otherwise swamp the histogram.
+			if (gamestate == GS_LEVEL && inlevel)
+			{
+				tictimes.Push(elapsed);
+				totaltime += elapsed;
+			}
+			else if (gamestate == GS_LEVEL)
+			{
+				inlevel = true;
+			}
+			else if (inlevel)
+			{
+				// demo ended or the level was exited.
+				break;
+			}
+		}
+		catch (CRecoverableError &error)
+		{
+			if (error.GetMessage ())
+			{
+				Printf (PRINT_BOLD, "\n%s\n", error.GetMessage());
+			}
+			break;
+		}
+		catch (CVMAbortException &error)
+		{
+			error.MaybePrintMessage();
+			Printf("%s", error.stacktrace.GetChars());
+			break;
+		}
+	}
+	D_PrintBenchResults(tictimes, totaltime);
+	exit(0);
+}
+
 //==========================================================================
 //
 // D_PageTicker
@@ -2272,6 +2400,13 @@ void D_DoomMain (void)
 		Printf("\n");
 	}
 
+	const char *bench = Args->CheckValue("-benchtics");
+	if (bench != NULL)
+	{
+		benchrun = true;
+		benchtics = MAX(1, (int)strtol(bench, NULL, 0));
+	}
+
 	if (Args->CheckParm("-hashfiles"))
 	{
 		const char *filename = "fileinfo.txt";
@@ -263,18 +263,18 @@ private:
 
 	void *operator new(size_t len, nonew&)
 	{
-		return M_Malloc(len);
+		return GC::AllocObject(len);
 	}
 public:
 
 	void operator delete (void *mem, nonew&)
 	{
-		M_Free(mem);
+		GC::FreeObject(mem);
 	}
 
 	void operator delete (void *mem)
 	{
-		M_Free(mem);
+		GC::FreeObject(mem);
 	}
 
 	// GC fiddling
@@ -341,7 +341,7 @@ protected:
 
 	void operator delete (void *mem, EInPlace *)
 	{
-		M_Free (mem);
+		GC::FreeObject (mem);
 	}
 
 	template<typename T, typename... Args>
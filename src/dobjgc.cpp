@@ -135,6 +135,9 @@ extern DThinker *NextToThink;
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
+// Only affects objects allocated from now on; existing ones keep their storage.
+CVAR(Bool, gc_objectpool, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
 namespace GC
 {
 size_t AllocBytes;
@@ -633,6 +636,117 @@ void DelSoftRoot(DObject *obj)
 	}
 }
 
+//==========================================================================
+//
+// Object pool
+//
+// Objects up to POOLMAXSIZE bytes are carved out of per-size-class chunks
+// and recycled through a free list when the sweep deletes them, so the
+// projectile and puff churn does not go through malloc, and objects of
+// one class (which all have the same size) end up next to each other.
+// Every object is preceded by a small header naming its size class, which
+// is how Free() tells pooled storage from plain allocations. Pool slots
+// are counted in AllocBytes just like malloc'd objects so the collector's
+// pacing does not change. Objects are only created and destroyed on the
+// main thread, so there is no locking.
+//
+//==========================================================================
+
+enum
+{
+	POOLGRANULARITY = 16,
+	POOLMAXSIZE = 4096,
+	POOLNUMCLASSES = POOLMAXSIZE / POOLGRANULARITY,
+	POOLCHUNKSIZE = 65536,
+	POOLBIGCLASS = 0xffffffffu
+};
+
+struct FPoolHeader
+{
+	uint32_t SizeClass;
+	uint32_t Pad[3];	// keep the object 16 byte aligned
+};
+
+struct FPoolClass
+{
+	void *FreeList;
+	uint8_t *ChunkPos;	// unused part of the newest chunk
+	uint8_t *ChunkEnd;
+	size_t Live;
+	size_t Slots;
+};
+
+static FPoolClass PoolClasses[POOLNUMCLASSES];
+static size_t PoolChunkBytes, PoolBigObjects;
+
+static inline size_t SlotSize(unsigned sizeclass)
+{
+	return sizeof(FPoolHeader) + (sizeclass + 1) * POOLGRANULARITY;
+}
+
+void *AllocObject(size_t size)
+{
+	FPoolHeader *header;
+
+	if (!gc_objectpool || size == 0 || size > POOLMAXSIZE)
+	{
+		header = (FPoolHeader *)M_Malloc(sizeof(FPoolHeader) + size);
+		header->SizeClass = POOLBIGCLASS;
+		PoolBigObjects++;
+		return header + 1;
+	}
+
+	unsigned sizeclass = unsigned((size - 1) / POOLGRANULARITY);
+	FPoolClass &pc = PoolClasses[sizeclass];
+	size_t slotsize = SlotSize(sizeclass);
+
+	if (pc.FreeList != nullptr)
+	{
+		header = (FPoolHeader *)pc.FreeList;
+		pc.FreeList = *(void **)(header + 1);
+	}
+	else
+	{
+		if (pc.ChunkPos == nullptr || pc.ChunkPos + slotsize > pc.ChunkEnd)
+		{
+			size_t chunksize = MAX<size_t>(POOLCHUNKSIZE, slotsize * 16);
+			pc.ChunkPos = (uint8_t *)malloc(chunksize);
+			if (pc.ChunkPos == nullptr)
+			{
+				I_FatalError("Could not malloc %zu bytes", chunksize);
+			}
+			pc.ChunkEnd = pc.ChunkPos + chunksize;
+			pc.Slots += chunksize / slotsize;
+			PoolChunkBytes += chunksize;
+		}
+		header = (FPoolHeader *)pc.ChunkPos;
+		pc.ChunkPos += slotsize;
+	}
+	header->SizeClass = sizeclass;
+	pc.Live++;
+	AllocBytes += slotsize;
+	return header + 1;
+}
+
+void FreeObject(void *mem)
+{
+	if (mem == nullptr) return;
+
+	FPoolHeader *header = (FPoolHeader *)mem - 1;
+	if (header->SizeClass == POOLBIGCLASS)
+	{
+		PoolBigObjects--;
+		M_Free(header);
+		return;
+	}
+
+	FPoolClass &pc = PoolClasses[header->SizeClass];
+	*(void **)mem = pc.FreeList;
+	pc.FreeList = header;
+	pc.Live--;
+	AllocBytes -= SlotSize(header->SizeClass);
+}
+
 }
 
 //==========================================================================
@@ -735,6 +849,35 @@ ADD_STAT(gc)
 	return out;
 }
 
+//==========================================================================
+//
+// STAT objpool
+//
+// Shows how much of the object pool is in use.
+//
+//==========================================================================
+
+ADD_STAT(objpool)
+{
+	size_t classes = 0, live = 0, used = 0, slots = 0;
+
+	for (auto &pc : GC::PoolClasses)
+	{
+		if (pc.Slots == 0) continue;
+		classes++;
+		live += pc.Live;
+		used += pc.Live * GC::SlotSize(unsigned(&pc - GC::PoolClasses));
+		slots += pc.Slots;
+	}
+	FString out;
+	out.Format("Pooled: %zu objects in %zu/%zu slots, %d size classes  Chunks:%6zuK  Used:%6zuK (%.1f%%)  Unpooled: %zu",
+		live, live, slots, int(classes),
+		(GC::PoolChunkBytes + 1023) >> 10, (used + 1023) >> 10,
+		GC::PoolChunkBytes > 0 ? used * 100. / GC::PoolChunkBytes : 0.,
+		GC::PoolBigObjects);
+	return out;
+}
+
 //==========================================================================
 //
 // CCMD gc
@@ -123,6 +123,10 @@ namespace GC
 	// Marks an array of objects.
 	void MarkArray(DObject **objs, size_t count);
 
+	// Allocates and frees the storage for a DObject, using the object pool if possible.
+	void *AllocObject(size_t size);
+	void FreeObject(void *mem);
+
 	// For cleanup
 	void DelSoftRootHead();
 
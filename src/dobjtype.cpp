@@ -49,6 +49,7 @@
 #include "vm.h"
 #include "types.h"
 #include "scriptutil.h"
+#include "backend/vmbuilder.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -258,6 +259,7 @@ void PClass::StaticShutdown ()
 	}
 	ScriptUtil::Clear();
 	FunctionPtrList.Clear();
+	FunctionBuildList.DropDeferred();
 	VMFunction::DeleteAll();
 
 	// Make a full garbage collection here so that all destroyed but uncollected higher level objects 
@@ -448,7 +450,7 @@ PClass *PClass::FindClass (FName zaname)
 
 DObject *PClass::CreateNew()
 {
-	uint8_t *mem = (uint8_t *)M_Malloc (Size);
+	uint8_t *mem = (uint8_t *)GC::AllocObject (Size);
 	assert (mem != nullptr);
 
 	// Set this object's defaults before constructing it.
@@ -459,7 +461,7 @@ DObject *PClass::CreateNew()
 
 	if (ConstructNative == nullptr)
 	{
-		M_Free(mem);
+		GC::FreeObject(mem);
 		I_Error("Attempt to instantiate abstract class %s.", TypeName.GetChars());
 	}
 	ConstructNative (mem);
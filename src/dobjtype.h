@@ -64,6 +64,7 @@ public:
 	bool				 bDecorateClass = false;	// may be subject to some idiosyncracies due to DECORATE backwards compatibility
 	bool				 bAbstract = false;
 	bool				 bOptional = false;
+	bool				 bCodePending = false;	// some of its functions get generated on first use
 	TArray<VMFunction*>	 Virtuals;	// virtual function table
 	TArray<FTypeAndOffset> MetaInits;
 	TArray<FTypeAndOffset> SpecialInits;
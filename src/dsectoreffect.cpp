@@ -165,6 +165,7 @@ EMoveResult sector_t::MoveFloor(double speed, double dest, int crush, int direct
 	double		move;
 	//double		destheight;	//jff 02/04/98 used to keep floors/ceilings
 							// from moving thru each other
+	P_InvalidateSightCache(this);
 	lastpos = floorplane.fD();
 	switch (direction)
 	{
@@ -301,6 +302,7 @@ EMoveResult sector_t::MoveCeiling(double speed, double dest, int crush, int dire
 	//double		destheight;	//jff 02/04/98 used to keep floors/ceilings
 	// from moving thru each other
 
+	P_InvalidateSightCache(this);
 	lastpos = ceilingplane.fD();
 	switch (direction)
 	{
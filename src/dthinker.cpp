@@ -40,6 +40,8 @@
 #include "vm.h"
 #include "c_dispatch.h"
 #include "v_text.h"
+#include "i_time.h"
+#include "p_thinkerprofile.h"
 
 
 static int ThinkCount;
@@ -600,7 +602,9 @@ void DThinker::RunThinkers ()
 
 	ThinkCycles.Clock();
 
-	if (!profilethinkers)
+	const bool recording = ThinkerProfiler.IsRecording();
+
+	if (!profilethinkers && !recording)
 	{
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
@@ -621,6 +625,8 @@ void DThinker::RunThinkers ()
 	else
 	{
 		Profiles.Clear();
+		if (recording) ThinkerProfiler.BeginTic(gametic);
+
 		// Tick every thinker left from last time
 		for (i = STAT_FIRST_THINKING; i <= MAX_STATNUM; ++i)
 		{
@@ -637,62 +643,67 @@ void DThinker::RunThinkers ()
 			}
 		} while (count != 0);
 
-		struct SortedProfileInfo
-		{
-			const char* className;
-			int numcalls;
-			double time;
-		};
+		if (recording) ThinkerProfiler.EndTic();
 
-		TArray<SortedProfileInfo> sorted;
-		sorted.Grow(Profiles.CountUsed());
-
-		auto it = TMap<FName, ProfileInfo>::Iterator(Profiles);
-		TMap<FName, ProfileInfo>::Pair *pair;
-		while (it.NextPair(pair))
+		if (profilethinkers)
 		{
-			sorted.Push({ pair->Key.GetChars(), pair->Value.numcalls, pair->Value.timer.TimeMS() });
-		}
+			struct SortedProfileInfo
+			{
+				const char* className;
+				int numcalls;
+				double time;
+			};
 
-		std::sort(sorted.begin(), sorted.end(), [](const SortedProfileInfo& left, const SortedProfileInfo& right)
-		{
-			switch (profilethinkers)
+			TArray<SortedProfileInfo> sorted;
+			sorted.Grow(Profiles.CountUsed());
+
+			auto it = TMap<FName, ProfileInfo>::Iterator(Profiles);
+			TMap<FName, ProfileInfo>::Pair *pair;
+			while (it.NextPair(pair))
 			{
-			case 1: // by name, from A to Z
-				return stricmp(left.className, right.className) < 0;
-			case 2: // by name, from Z to A
-				return stricmp(right.className, left.className) < 0;
-			case 3: // number of calls, ascending
-				return left.numcalls < right.numcalls;
-			case 4: // number of calls, descending
-				return right.numcalls < left.numcalls;
-			case 5: // average time, ascending
-				return left.time / left.numcalls < right.time / right.numcalls;
-			case 6: // average time, descending
-				return right.time / right.numcalls < left.time / left.numcalls;
-			case 7: // total time, ascending
-				return left.time < right.time;
-			default: // total time, descending
-				return right.time < left.time;
+				sorted.Push({ pair->Key.GetChars(), pair->Value.numcalls, pair->Value.timer.TimeMS() });
 			}
-		});
 
-		Printf(TEXTCOLOR_YELLOW "Total, ms   Averg, ms   Calls   Actor class\n");
-		Printf(TEXTCOLOR_YELLOW "----------  ----------  ------  --------------------\n");
+			std::sort(sorted.begin(), sorted.end(), [](const SortedProfileInfo& left, const SortedProfileInfo& right)
+			{
+				switch (profilethinkers)
+				{
+				case 1: // by name, from A to Z
+					return stricmp(left.className, right.className) < 0;
+				case 2: // by name, from Z to A
+					return stricmp(right.className, left.className) < 0;
+				case 3: // number of calls, ascending
+					return left.numcalls < right.numcalls;
+				case 4: // number of calls, descending
+					return right.numcalls < left.numcalls;
+				case 5: // average time, ascending
+					return left.time / left.numcalls < right.time / right.numcalls;
+				case 6: // average time, descending
+					return right.time / right.numcalls < left.time / left.numcalls;
+				case 7: // total time, ascending
+					return left.time < right.time;
+				default: // total time, descending
+					return right.time < left.time;
+				}
+			});
 
-		const unsigned count = MIN(profilelimit > 0 ? profilelimit : UINT_MAX, sorted.Size());
+			Printf(TEXTCOLOR_YELLOW "Total, ms   Averg, ms   Calls   Actor class\n");
+			Printf(TEXTCOLOR_YELLOW "----------  ----------  ------  --------------------\n");
 
-		for (unsigned i = 0; i < count; ++i)
-		{
-			const SortedProfileInfo& info = sorted[i];
-			Printf("%s%10.6f  %s%10.6f  %s%6d  %s%s\n",
-				profilethinkers >= 7 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.time,
-				profilethinkers == 5 || profilethinkers == 6 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.time / info.numcalls,
-				profilethinkers == 3 || profilethinkers == 4 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.numcalls,
-				profilethinkers == 1 || profilethinkers == 2 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.className);
-		}
+			const unsigned count = MIN(profilelimit > 0 ? profilelimit : UINT_MAX, sorted.Size());
 
-		profilethinkers = 0;
+			for (unsigned i = 0; i < count; ++i)
+			{
+				const SortedProfileInfo& info = sorted[i];
+				Printf("%s%10.6f  %s%10.6f  %s%6d  %s%s\n",
+					profilethinkers >= 7 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.time,
+					profilethinkers == 5 || profilethinkers == 6 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.time / info.numcalls,
+					profilethinkers == 3 || profilethinkers == 4 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.numcalls,
+					profilethinkers == 1 || profilethinkers == 2 ? TEXTCOLOR_YELLOW : TEXTCOLOR_WHITE, info.className);
+			}
+
+			profilethinkers = 0;
+		}
 	}
 
 	ThinkCycles.Unclock();
@@ -783,11 +794,18 @@ int DThinker::ProfileThinkers(FThinkerList *list, FThinkerList *dest)
 		{ // Only tick thinkers not scheduled for destruction
 			ThinkCount++;
 
-			auto &prof = Profiles[node->GetClass()->TypeName];
+			auto cls = node->GetClass();
+			auto &prof = Profiles[cls->TypeName];
+			FState *state = node->IsKindOf(RUNTIME_CLASS(AActor)) ? static_cast<AActor *>(node)->state : nullptr;
+			uint64_t start = I_nsTime();
 			prof.numcalls++;
 			prof.timer.Clock();
 			node->CallTick();
 			prof.timer.Unclock();
+			if (ThinkerProfiler.IsRecording())
+			{
+				ThinkerProfiler.AddThinker(cls, state, I_nsTime() - start);
+			}
 			node->ObjectFlags &= ~OF_JustSpawned;
 			GC::CheckGC();
 		}
@@ -175,11 +175,12 @@ static void add_char(char *tokn, char c)
 //
 //==========================================================================
 
-char *FParser::GetTokens(char *s)
+char *FParser::Tokenize(char *s)
 {
 	char *tokn = NULL;
 
 	Rover = s;
+	Tokens[0] = TokenBuffer;
 	NumTokens = 1;
 	Tokens[0][0] = 0; TokenType[NumTokens-1] = name_;
 	
@@ -283,6 +284,67 @@ char *FParser::GetTokens(char *s)
 	return Rover;
 }
 
+//==========================================================================
+//
+// GetTokens
+//
+// Statements of the script itself are only tokenized the first time they
+// are reached. Includes are run from a temporary buffer and are always
+// tokenized.
+//
+//==========================================================================
+
+char *FParser::GetTokens(char *s)
+{
+	if (s < Script->data || s > Script->data + Script->len)
+	{
+		Statement = NULL;
+		return Tokenize(s);
+	}
+
+	int offset = Script->MakeIndex(s);
+	FFsStatement **cached = Script->Statements.CheckKey(offset);
+	FFsStatement *stmt;
+	if (cached != NULL)
+	{
+		stmt = *cached;
+		NumTokens = stmt->TokenStart.Size();
+		for (int i = 0; i < NumTokens; i++)
+		{
+			Tokens[i] = &stmt->Text[stmt->TokenStart[i]];
+			TokenType[i] = stmt->TokenType[i];
+		}
+		Section = stmt->Section;
+		BraceType = stmt->BraceType;
+		LineStart = Script->data + stmt->LineStart;
+		Rover = Script->data + stmt->Next;
+	}
+	else
+	{
+		Tokenize(s);
+
+		stmt = new FFsStatement;
+		if (NumTokens > 0)
+		{
+			char *last = Tokens[NumTokens - 1];
+			stmt->Text.Resize(unsigned(last + strlen(last) + 1 - TokenBuffer));
+			memcpy(&stmt->Text[0], TokenBuffer, stmt->Text.Size());
+			for (int i = 0; i < NumTokens; i++)
+			{
+				stmt->TokenStart.Push(int(Tokens[i] - TokenBuffer));
+				stmt->TokenType.Push(TokenType[i]);
+			}
+		}
+		stmt->Section = Section;
+		stmt->BraceType = BraceType;
+		stmt->LineStart = Script->MakeIndex(LineStart);
+		stmt->Next = Script->MakeIndex(Rover);
+		Script->Statements[offset] = stmt;
+	}
+	Statement = stmt;
+	return Rover;
+}
+
 
 //==========================================================================
 //
@@ -632,19 +694,18 @@ void FParser::PointlessBrackets(int *start, int *stop)
 //
 //==========================================================================
 
-void FParser::EvaluateExpression(svalue_t &result, int start, int stop)
+void FParser::SplitExpression(FFsSplit &split)
 {
 	int i, n;
-	
+
+	split.Op = -1;
+
 	// possible pointless brackets
-	if(TokenType[start] == operator_ && TokenType[stop] == operator_)
-		PointlessBrackets(&start, &stop);
+	if(TokenType[split.Start] == operator_ && TokenType[split.Stop] == operator_)
+		PointlessBrackets(&split.Start, &split.Stop);
 
-	if(start == stop)       // only 1 thing to evaluate
-    {
-		SimpleEvaluate(result, start);
+	if(split.Start == split.Stop)       // only 1 thing to evaluate
 		return;
-    }
 	
 	// go through each operator in order of precedence
 	for(i=0; i<num_operators; i++)
@@ -655,20 +716,64 @@ void FParser::EvaluateExpression(svalue_t &result, int start, int stop)
 		
 		if (operators[i].direction==forward)
 		{
-			n = FindOperatorBackwards(start, stop, operators[i].string);
+			n = FindOperatorBackwards(split.Start, split.Stop, operators[i].string);
 		}
 		else
 		{
-			n = FindOperator(start, stop, operators[i].string);
+			n = FindOperator(split.Start, split.Stop, operators[i].string);
 		}
 
 		if( n != -1)
 		{
-			// call the operator function and evaluate this chunk of tokens
-			(this->*operators[i].handler)(result, start, n, stop);
+			split.Op = i;
+			split.N = n;
 			return;
 		}
     }
+}
+
+void FParser::EvaluateExpression(svalue_t &result, int start, int stop)
+{
+	int i;
+	FFsSplit split;
+
+	// The split only depends on the tokens, so for cached statements it is only worked out once.
+	if (Statement != NULL)
+	{
+		FFsSplit *cached = Statement->Splits.CheckKey(start * T_MAXTOKENS + stop);
+		if (cached != NULL)
+		{
+			split = *cached;
+		}
+		else
+		{
+			split.Start = start;
+			split.Stop = stop;
+			SplitExpression(split);
+			Statement->Splits[start * T_MAXTOKENS + stop] = split;
+		}
+	}
+	else
+	{
+		split.Start = start;
+		split.Stop = stop;
+		SplitExpression(split);
+	}
+	start = split.Start;
+	stop = split.Stop;
+
+	if(start == stop)       // only 1 thing to evaluate
+    {
+		SimpleEvaluate(result, start);
+		return;
+    }
+
+	if(split.Op >= 0)
+	{
+		// call the operator function and evaluate this chunk of tokens
+		(this->*operators[split.Op].handler)(result, start, split.N, stop);
+		return;
+	}
 	
 	if(TokenType[start] == function)
 	{
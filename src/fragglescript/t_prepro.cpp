@@ -131,6 +131,25 @@ void DFsScript::ClearSections()
 		}
 		sections[i] = NULL;
 	}
+	// the cached statements point to the sections.
+	ClearStatements();
+}
+
+//==========================================================================
+//
+// clear the tokenized statements
+//
+//==========================================================================
+
+void DFsScript::ClearStatements()
+{
+	TMap<int, FFsStatement *>::Iterator it(Statements);
+	TMap<int, FFsStatement *>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		delete pair->Value;
+	}
+	Statements.Clear();
 }
 
 //==========================================================================
@@ -388,6 +407,7 @@ void DFsScript::DryRunScript()
 
 void DFsScript::Preprocess()
 {
+	ClearStatements();
 	len = (int)strlen(data);
 	ProcessFindChar(data, 0);  // fill in everything
 	DryRunScript();
@@ -159,6 +159,7 @@ DFsScript::~DFsScript()
 {
 	if (data != NULL) delete[] data;
 	data = NULL;
+	ClearStatements();
 }
 
 //==========================================================================
@@ -171,6 +172,7 @@ void DFsScript::OnDestroy()
 {
 	ClearVariables(true);
 	ClearSections();
+	ClearStatements();
 	ClearChildren();
 	parent = NULL;
 	if (data != NULL) delete [] data;
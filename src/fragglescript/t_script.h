@@ -262,6 +262,34 @@ enum    // brace types: where current_section is a { or }
 	bracket_close
 };
 
+//==========================================================================
+//
+// Statements that have been split into tokens. They are cached by their
+// offset in the script, so loops and scripts that run every tic only get
+// tokenized once, and each expression range within them is only scanned
+// for its operator once.
+//
+//==========================================================================
+
+struct FFsSplit
+{
+	int Start, Stop;	// with pointless brackets removed
+	int Op;				// index into FParser::operators, -1 if none was found
+	int N;				// operator token
+};
+
+struct FFsStatement
+{
+	TArray<char> Text;		// the tokens, each null terminated
+	TArray<int> TokenStart;
+	TArray<tokentype_t> TokenType;
+	DFsSection *Section;
+	int BraceType;
+	int LineStart;			// offsets into the script
+	int Next;
+	TMap<int, FFsSplit> Splits;		// by start * T_MAXTOKENS + stop
+};
+
 //==========================================================================
 //
 // Errors
@@ -332,6 +360,8 @@ public:
 	bool lastiftrue;     // haleyjd: whether last "if" statement was 
 	// true or false
 
+	TMap<int, FFsStatement *> Statements;	// not serialized, it gets rebuilt on demand
+
 	DFsScript();
 	~DFsScript();
 	void OnDestroy() override;
@@ -351,6 +381,7 @@ public:
 	char *SectionLoop(const DFsSection *sec);
 	void ClearSections();
 	void ClearChildren();
+	void ClearStatements();
 
 	int MakeIndex(const char *p) { return int(p-data); }
 
@@ -395,9 +426,11 @@ struct FParser
 	char *LineStart;
 	char *Rover;
 
+	char *TokenBuffer;
 	char *Tokens[T_MAXTOKENS];
 	tokentype_t TokenType[T_MAXTOKENS];
 	int NumTokens;
+	FFsStatement *Statement;	// cache entry of the current statement, if it is from the script itself
 	DFsScript *Script;       // the current script
 	DFsSection *Section;
 	DFsSection *PrevSection;
@@ -412,8 +445,9 @@ struct FParser
 	{
 		LineStart = NULL;
 		Rover = NULL;
-		Tokens[0] = new char[scr->len+32];	// 32 for safety. FS seems to need a few bytes more than the script's actual length.
+		Tokens[0] = TokenBuffer = new char[scr->len+32];	// 32 for safety. FS seems to need a few bytes more than the script's actual length.
 		NumTokens = 0;
+		Statement = NULL;
 		Script = scr;
 		Section = PrevSection = NULL;
 		BraceType = 0;
@@ -421,11 +455,12 @@ struct FParser
 
 	~FParser()
 	{
-		if (Tokens[0]) delete [] Tokens[0];
+		if (TokenBuffer) delete [] TokenBuffer;
 	}
 
 	void NextToken();
 	char *GetTokens(char *s);
+	char *Tokenize(char *s);
 	void PrintTokens();
 	void ErrorMessage(FString msg);
 
@@ -435,6 +470,7 @@ struct FParser
 	int FindOperatorBackwards(int start, int stop, const char *value);
 	void SimpleEvaluate(svalue_t &, int n);
 	void PointlessBrackets(int *start, int *stop);
+	void SplitExpression(FFsSplit &split);
 	void EvaluateExpression(svalue_t &, int start, int stop);
 	void EvaluateFunction(svalue_t &, int start, int stop);
 
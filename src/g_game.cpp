@@ -1027,6 +1027,10 @@ void G_Ticker ()
 	int i;
 	gamestate_t	oldgamestate;
 
+	VMProfilerTick();
+	JitInstallBackground();
+	VMFinishSomeDeferred();
+
 	// do player reborns if needed
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
@@ -232,9 +232,8 @@ int FFlatVertexBuffer::CreateIndexedVertices(int h, sector_t *sec, const secplan
 //
 //==========================================================================
 
-void FFlatVertexBuffer::CreateIndexedFlatVertices()
+void FFlatVertexBuffer::CreateIndexedFlatVertices(VertexContainers &verts)
 {
-    auto verts = BuildVertices();
 
 	int i = 0;
 	/*
@@ -310,10 +309,10 @@ void FFlatVertexBuffer::UpdatePlaneVertices(sector_t *sec, int plane)
 //
 //==========================================================================
 
-void FFlatVertexBuffer::CreateVertices()
+void FFlatVertexBuffer::CreateVertices(VertexContainers &verts)
 {
 	vbo_shadowdata.Resize(NUM_RESERVED);
-	CreateIndexedFlatVertices();
+	CreateIndexedFlatVertices(verts);
 }
 
 //==========================================================================
@@ -390,10 +389,10 @@ void FFlatVertexBuffer::Copy(int start, int count)
 //
 //==========================================================================
 
-void FFlatVertexBuffer::CreateVBO()
+void FFlatVertexBuffer::CreateVBO(VertexContainers &verts)
 {
 	vbo_shadowdata.Resize(mNumReserved);
-	FFlatVertexBuffer::CreateVertices();
+	FFlatVertexBuffer::CreateVertices(verts);
 	mCurIndex = mIndex = vbo_shadowdata.Size();
 	Copy(0, mIndex);
 	mIndexBuffer->SetData(ibo_data.Size() * sizeof(uint32_t), &ibo_data[0]);
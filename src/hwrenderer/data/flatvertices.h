@@ -84,7 +84,8 @@ public:
 		return std::make_pair(mVertexBuffer, mIndexBuffer);
 	}
 
-	void CreateVBO();
+	// The vertices come from BuildVertices, which the level loader runs in the background.
+	void CreateVBO(VertexContainers &verts);
 	void Copy(int start, int count);
 
 	FFlatVertex *GetBuffer(int index) const
@@ -119,11 +120,11 @@ private:
 	int CreateIndexedSectionVertices(subsector_t *sub, const secplane_t &plane, int floor, VertexContainer &cont);
 	int CreateIndexedSectorVertices(sector_t *sec, const secplane_t &plane, int floor, VertexContainer &cont);
 	int CreateIndexedVertices(int h, sector_t *sec, const secplane_t &plane, int floor, VertexContainers &cont);
-	void CreateIndexedFlatVertices();
+	void CreateIndexedFlatVertices(VertexContainers &verts);
 
 	void UpdatePlaneVertices(sector_t *sec, int plane);
 protected:
-	void CreateVertices();
+	void CreateVertices(VertexContainers &verts);
 	void CheckPlanes(sector_t *sector);
 public:
 	void CheckUpdate(sector_t *sector);
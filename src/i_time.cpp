@@ -35,6 +35,12 @@
 
 #include <chrono>
 #include <thread>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 #include "i_time.h"
 #include "doomdef.h"
 #include "c_cvars.h"
@@ -158,6 +164,21 @@ uint64_t I_nsTime()
 	return GetClockTimeNS();
 }
 
+uint64_t I_ThreadCPUTimeNS()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return 0;
+	uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+	uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+	return (k + u) * 100;	// FILETIME counts 100ns intervals
+#else
+	timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
 uint64_t I_msTime()
 {
 	return NSToMS(I_nsTime());
@@ -27,3 +27,6 @@ uint64_t I_msTimeFS();
 
 // Nanosecond-accurate time
 uint64_t I_nsTime();
+
+// CPU time consumed by the calling thread, in nanoseconds
+uint64_t I_ThreadCPUTimeNS();
@@ -52,6 +52,8 @@
 #include "types.h"
 #include "w_wad.h"
 #include "g_levellocals.h"
+#include "i_time.h"
+#include "p_thinkerprofile.h"
 
 extern void LoadActors ();
 extern void InitBotStuff();
@@ -161,6 +163,7 @@ bool FState::CallAction(AActor *self, AActor *stateowner, FStateParamInfo *info,
 	if (ActionFunc != nullptr)
 	{
 		ActionCycles.Clock();
+		uint64_t start = ThinkerProfiler.IsRecording() ? I_nsTime() : 0;
 
 		// If the function returns a state, store it at *stateret.
 		// If it doesn't return a state but stateret is non-nullptr, we need
@@ -236,6 +239,7 @@ bool FState::CallAction(AActor *self, AActor *stateowner, FStateParamInfo *info,
 		}
 
 		ActionCycles.Unclock();
+		if (start != 0) ThinkerProfiler.AddFunction(ActionFunc, I_nsTime() - start);
 		return true;
 	}
 	else
@@ -40,14 +40,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <vector>
 
 #include "doomdata.h"
 #include "nodebuild.h"
+#include "c_cvars.h"
+#include "ctpl.h"
+#include "p_loadtasks.h"
 
 const int MaxSegs = 64;
 const int SplitCost = 8;
 const int AAPreference = 16;
 
+CVAR (Bool, nodebuild_parallel, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
+
 #if 0
 #define D(x) x
 #else
@@ -456,6 +462,10 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 
 	D(Printf (PRINT_LOG, "Processing set %d\n", set));
 
+	// Gather the candidates first so that they can be scored in parallel.
+	// The best one is then picked in the original order so that the result
+	// is the same as if they had been scored one by one.
+	Candidates.Clear();
 	while (seg != DWORD_MAX)
 	{
 		FPrivSeg *pseg = &Segs[seg];
@@ -473,28 +483,35 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 				}
 
 				stepleft = step;
-				SetNodeFromSeg (node, pseg);
-
-				int value = Heuristic (node, set, nosplit);
-
-				D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
-					(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
-
-				if (value > bestvalue)
-				{
-					bestvalue = value;
-					bestseg = seg;
-				}
-				else if (value < 0)
-				{
-					nosplitters = true;
-				}
+				Candidates.Push(seg);
 			}
 		}
 
 		seg = pseg->next;
 	}
 
+	ScoreCandidates (set, nosplit);
+
+	for (unsigned i = 0; i < Candidates.Size(); ++i)
+	{
+		int value = CandidateScores[i];
+		seg = Candidates[i];
+
+		D(SetNodeFromSeg (node, &Segs[seg]));
+		D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
+			(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
+
+		if (value > bestvalue)
+		{
+			bestvalue = value;
+			bestseg = seg;
+		}
+		else if (value < 0)
+		{
+			nosplitters = true;
+		}
+	}
+
 	if (bestseg == DWORD_MAX)
 	{ // No lines split any others into two sets, so this is a convex region.
 	D(Printf (PRINT_LOG, "set %d, step %d, nosplit %d has no good splitter (%d)\n", set, step, nosplit, nosplitters));
@@ -508,6 +525,57 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	return 1;
 }
 
+// Runs Heuristic for every seg in Candidates. Each candidate's score only
+// depends on the segs in the set, which are not modified while scoring, so
+// large sets are spread across the loader's thread pool with every chunk
+// using its own scratch lists.
+
+void FNodeBuilder::ScoreCandidates (uint32_t set, bool honorNoSplit)
+{
+	enum { MIN_PER_CHUNK = 32 };
+
+	unsigned count = Candidates.Size();
+	CandidateScores.Resize(count);
+
+	auto scorerange = [=](unsigned start, unsigned end, TArray<int> &touched, TArray<int> &colinear)
+	{
+		node_t node;
+		for (unsigned i = start; i < end; ++i)
+		{
+			SetNodeFromSeg (node, &Segs[Candidates[i]]);
+			CandidateScores[i] = Heuristic (node, set, honorNoSplit, touched, colinear);
+		}
+	};
+
+	unsigned numchunks = 1;
+	if (nodebuild_parallel)
+	{
+		numchunks = MIN<unsigned>(count / MIN_PER_CHUNK, FLoadTaskGraph::Pool().size() + 1);
+	}
+	if (numchunks <= 1)
+	{
+		scorerange (0, count, Touched, Colinear);
+		return;
+	}
+
+	std::vector<std::future<void>> futures;
+	unsigned chunksize = (count + numchunks - 1) / numchunks;
+	for (unsigned start = chunksize; start < count; start += chunksize)
+	{
+		unsigned end = MIN(start + chunksize, count);
+		futures.push_back(FLoadTaskGraph::Pool().push([=](int)
+		{
+			TArray<int> touched, colinear;
+			scorerange (start, end, touched, colinear);
+		}));
+	}
+	scorerange (0, chunksize, Touched, Colinear);
+	for (auto &future : futures)
+	{
+		future.get();
+	}
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
@@ -515,6 +583,11 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 // in the set.
 
 int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+{
+	return Heuristic (node, set, honorNoSplit, Touched, Colinear);
+}
+
+int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
 	// Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
 	int score = 1000000;
@@ -529,8 +602,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	unsigned int max, m2, p, q;
 	double frac;
 
-	Touched.Clear ();
-	Colinear.Clear ();
+	touched.Clear ();
+	colinear.Clear ();
 
 	while (i != DWORD_MAX)
 	{
@@ -556,32 +629,32 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 			{
 				if ((sidev[0] | sidev[1]) != 0)
 				{
-					max = Touched.Size();
+					max = touched.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Touched[p] == test->loopnum)
+						if (touched[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Touched.Push (test->loopnum);
+						touched.Push (test->loopnum);
 					}
 				}
 				else
 				{
-					max = Colinear.Size();
+					max = colinear.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Colinear[p] == test->loopnum)
+						if (colinear[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Colinear.Push (test->loopnum);
+						colinear.Push (test->loopnum);
 					}
 				}
 			}
@@ -698,8 +771,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	// seg of that sector must be crossing the container's corner and does not
 	// actually split the container.
 
-	max = Touched.Size ();
-	m2 = Colinear.Size ();
+	max = touched.Size ();
+	m2 = colinear.Size ();
 
 	// If honorNoSplit is false, then both these lists will be empty.
 
@@ -712,10 +785,10 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 
 	for (p = 0; p < max; ++p)
 	{
-		int look = Touched[p];
+		int look = touched[p];
 		for (q = 0; q < m2; ++q)
 		{
-			if (look == Colinear[q])
+			if (look == colinear[q])
 			{
 				break;
 			}
@@ -75,6 +75,9 @@
 #include "actorinlines.h"
 #include "types.h"
 #include "scriptutil.h"
+#include "i_time.h"
+#include "p_thinkerprofile.h"
+#include "p_acsjit.h"
 
 	// P-codes for ACS scripts
 	enum
@@ -912,6 +915,12 @@ FACSStack::~FACSStack()
 //     about always having the same libraries loaded in the same order on
 //     every map that needs to use those strings.
 //
+// Most strings made by strparam are only needed by the script that made
+// them, for as long as it runs. So the automatic collections only consider
+// the strings added since the previous one, and only every YOUNG_GCS-th one
+// goes through the whole pool. Anything that outlived a collection was
+// stored somewhere and is likely to stay around.
+//
 //----------------------------------------------------------------------------
 
 ACSStringPool GlobalACSStrings;
@@ -935,8 +944,12 @@ void ACSStringPool::PoolEntry::Unlock()
 
 ACSStringPool::ACSStringPool()
 {
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
+	Buckets.Resize(MIN_BUCKETS);
+	for (auto &b : Buckets) b = NO_ENTRY;
 	FirstFreeEntry = 0;
+	UsedCount = 0;
+	Epoch = 1;
+	YoungSinceFull = 0;
 }
 
 //============================================================================
@@ -950,8 +963,12 @@ ACSStringPool::ACSStringPool()
 void ACSStringPool::Clear()
 {
 	Pool.Clear();
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
+	Young.Clear();
+	Buckets.Resize(MIN_BUCKETS);
+	for (auto &b : Buckets) b = NO_ENTRY;
 	FirstFreeEntry = 0;
+	UsedCount = 0;
+	YoungSinceFull = 0;
 }
 
 //============================================================================
@@ -968,26 +985,24 @@ int ACSStringPool::AddString(const char *str)
 	if (str == nullptr) str = "";
 	size_t len = strlen(str);
 	unsigned int h = SuperFastHash(str, len);
-	unsigned int bucketnum = h % NUM_BUCKETS;
-	int i = FindString(str, len, h, bucketnum);
+	int i = FindString(str, len, h);
 	if (i >= 0)
 	{
 		return i | STRPOOL_LIBRARYID_OR;
 	}
 	FString fstr(str);
-	return InsertString(fstr, h, bucketnum);
+	return InsertString(fstr, h);
 }
 
 int ACSStringPool::AddString(FString &str)
 {
 	unsigned int h = SuperFastHash(str.GetChars(), str.Len());
-	unsigned int bucketnum = h % NUM_BUCKETS;
-	int i = FindString(str, str.Len(), h, bucketnum);
+	int i = FindString(str, str.Len(), h);
 	if (i >= 0)
 	{
 		return i | STRPOOL_LIBRARYID_OR;
 	}
-	return InsertString(str, h, bucketnum);
+	return InsertString(str, h);
 }
 
 //============================================================================
@@ -1053,7 +1068,7 @@ void ACSStringPool::MarkString(int strnum)
 	assert((strnum & LIBRARYID_MASK) == STRPOOL_LIBRARYID_OR);
 	strnum &= ~LIBRARYID_MASK;
 	assert((unsigned)strnum < Pool.Size());
-	Pool[strnum].Mark = true;
+	Pool[strnum].MarkEpoch = Epoch;
 }
 
 //============================================================================
@@ -1126,7 +1141,7 @@ void ACSStringPool::MarkStringArray(const int *strnum, unsigned int count)
 			num &= ~LIBRARYID_MASK;
 			if ((unsigned)num < Pool.Size())
 			{
-				Pool[num].Mark = true;
+				Pool[num].MarkEpoch = Epoch;
 			}
 		}
 	}
@@ -1153,7 +1168,7 @@ void ACSStringPool::MarkStringMap(const FWorldGlobalArray &aray)
 			num &= ~LIBRARYID_MASK;
 			if ((unsigned)num < Pool.Size())
 			{
-				Pool[num].Mark |= true;
+				Pool[num].MarkEpoch = Epoch;
 			}
 		}
 	}
@@ -1172,7 +1187,7 @@ void ACSStringPool::UnlockAll()
 {
 	for (unsigned int i = 0; i < Pool.Size(); ++i)
 	{
-		Pool[i].Mark = false;
+		Pool[i].MarkEpoch = 0;
 		Pool[i].Locks.Clear();
 	}
 }
@@ -1181,45 +1196,123 @@ void ACSStringPool::UnlockAll()
 //
 // ACSStringPool :: PurgeStrings
 //
-// Remove all unlocked strings from the pool.
+// Remove all unlocked strings from the pool. If 'young' is set, this may
+// only look at the strings added since the previous collection.
 //
 //============================================================================
 
-void ACSStringPool::PurgeStrings()
+void ACSStringPool::PurgeStrings(bool young)
 {
-	// Clear the hash buckets. We'll rebuild them as we decide what strings
-	// to keep and which to toss.
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	size_t usedcount = 0, freedcount = 0;
-	for (unsigned int i = 0; i < Pool.Size(); ++i)
+	if (young && YoungSinceFull < YOUNG_GCS)
 	{
-		PoolEntry *entry = &Pool[i];
-		if (entry->Next != FREE_ENTRY)
+		YoungSinceFull++;
+		Stats.YoungCollections++;
+		for (auto i : Young)
 		{
-			if (entry->Locks.Size() == 0 && !entry->Mark)
+			PoolEntry *entry = &Pool[i];
+			if (entry->Next != FREE_ENTRY && entry->Locks.Size() == 0 && entry->MarkEpoch != Epoch)
 			{
-				freedcount++;
-				// Mark this entry as free.
-				entry->Next = FREE_ENTRY;
-				if (i < FirstFreeEntry)
-				{
-					FirstFreeEntry = i;
-				}
-				// And free the string.
-				entry->Str = "";
+				UnlinkEntry(i);
+				FreeEntry(i);
 			}
-			else
+		}
+	}
+	else
+	{
+		YoungSinceFull = 0;
+		Stats.FullCollections++;
+		// Clear the hash buckets. We'll rebuild them as we decide what strings
+		// to keep and which to toss.
+		for (auto &b : Buckets) b = NO_ENTRY;
+		for (unsigned int i = 0; i < Pool.Size(); ++i)
+		{
+			PoolEntry *entry = &Pool[i];
+			if (entry->Next != FREE_ENTRY)
 			{
-				usedcount++;
-				// Rehash this entry.
-				unsigned int h = entry->Hash % NUM_BUCKETS;
-				entry->Next = PoolBuckets[h];
-				PoolBuckets[h] = i;
-				// Remove MarkString's mark.
-				entry->Mark = false;
+				if (entry->Locks.Size() == 0 && entry->MarkEpoch != Epoch)
+				{
+					FreeEntry(i);
+				}
+				else
+				{
+					LinkEntry(i);
+				}
 			}
 		}
 	}
+	Young.Clear();
+	// Remove MarkString's marks.
+	Epoch++;
+}
+
+//============================================================================
+//
+// ACSStringPool :: FreeEntry
+//
+// Marks an entry free. It must not be linked into a hash chain anymore.
+//
+//============================================================================
+
+void ACSStringPool::FreeEntry(unsigned int i)
+{
+	PoolEntry *entry = &Pool[i];
+	entry->Next = FREE_ENTRY;
+	if (i < FirstFreeEntry)
+	{
+		FirstFreeEntry = i;
+	}
+	// And free the string.
+	entry->Str = "";
+	UsedCount--;
+	Stats.Freed++;
+}
+
+//============================================================================
+//
+// ACSStringPool :: LinkEntry / UnlinkEntry
+//
+// Adds an entry to or removes it from its hash chain.
+//
+//============================================================================
+
+void ACSStringPool::LinkEntry(unsigned int i)
+{
+	unsigned int bucketnum = Pool[i].Hash & (Buckets.Size() - 1);
+	Pool[i].Next = Buckets[bucketnum];
+	Buckets[bucketnum] = i;
+}
+
+void ACSStringPool::UnlinkEntry(unsigned int i)
+{
+	unsigned int *link = &Buckets[Pool[i].Hash & (Buckets.Size() - 1)];
+	while (*link != i)
+	{
+		assert(*link != NO_ENTRY);
+		link = &Pool[*link].Next;
+	}
+	*link = Pool[i].Next;
+}
+
+//============================================================================
+//
+// ACSStringPool :: Rehash
+//
+// Redistributes the strings over a new number of buckets, so that the hash
+// chains stay short as the pool grows.
+//
+//============================================================================
+
+void ACSStringPool::Rehash(unsigned int numbuckets)
+{
+	Buckets.Resize(numbuckets);
+	for (auto &b : Buckets) b = NO_ENTRY;
+	for (unsigned int i = 0; i < Pool.Size(); ++i)
+	{
+		if (Pool[i].Next != FREE_ENTRY)
+		{
+			LinkEntry(i);
+		}
+	}
 }
 
 //============================================================================
@@ -1231,9 +1324,10 @@ void ACSStringPool::PurgeStrings()
 //
 //============================================================================
 
-int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsigned int bucketnum)
+int ACSStringPool::FindString(const char *str, size_t len, unsigned int h)
 {
-	unsigned int i = PoolBuckets[bucketnum];
+	Stats.Lookups++;
+	unsigned int i = Buckets[h & (Buckets.Size() - 1)];
 	while (i != NO_ENTRY)
 	{
 		PoolEntry *entry = &Pool[i];
@@ -1241,6 +1335,7 @@ int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsig
 		if (entry->Hash == h && entry->Str.Len() == len &&
 			memcmp(entry->Str.GetChars(), str, len) == 0)
 		{
+			Stats.Found++;
 			return i;
 		}
 		i = entry->Next;
@@ -1256,12 +1351,12 @@ int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsig
 //
 //============================================================================
 
-int ACSStringPool::InsertString(FString &str, unsigned int h, unsigned int bucketnum)
+int ACSStringPool::InsertString(FString &str, unsigned int h)
 {
 	unsigned int index = FirstFreeEntry;
 	if (index >= MIN_GC_SIZE && index == Pool.Max())
 	{ // We will need to grow the array. Try a garbage collection first.
-		P_CollectACSGlobalStrings();
+		P_CollectACSGlobalStrings(true);
 		index = FirstFreeEntry;
 	}
 	if (FirstFreeEntry >= STRPOOL_LIBRARYID_OR)
@@ -1280,10 +1375,14 @@ int ACSStringPool::InsertString(FString &str, unsigned int h, unsigned int bucke
 	PoolEntry *entry = &Pool[index];
 	entry->Str = str;
 	entry->Hash = h;
-	entry->Next = PoolBuckets[bucketnum];
-	entry->Mark = false;
+	entry->MarkEpoch = 0;
 	entry->Locks.Clear();
-	PoolBuckets[bucketnum] = index;
+	LinkEntry(index);
+	Young.Push(index);
+	if (++UsedCount > Buckets.Size())
+	{
+		Rehash(Buckets.Size() * 2);
+	}
 	return index | STRPOOL_LIBRARYID_OR;
 }
 
@@ -1325,7 +1424,7 @@ void ACSStringPool::ReadStrings(FSerializer &file, const char *key)
 		for (auto &p : Pool)
 		{
 			p.Next = FREE_ENTRY;
-			p.Mark = false;
+			p.MarkEpoch = 0;
 			p.Locks.Clear();
 		}
 		if (file.BeginArray("pool"))
@@ -1342,11 +1441,9 @@ void ACSStringPool::ReadStrings(FSerializer &file, const char *key)
 						file("string", Pool[ii].Str)
 							("locks", Pool[ii].Locks);
 
-						unsigned h = SuperFastHash(Pool[ii].Str, Pool[ii].Str.Len());
-						unsigned bucketnum = h % NUM_BUCKETS;
-						Pool[ii].Hash = h;
-						Pool[ii].Next = PoolBuckets[bucketnum];
-						PoolBuckets[bucketnum] = ii;
+						Pool[ii].Hash = SuperFastHash(Pool[ii].Str, Pool[ii].Str.Len());
+						LinkEntry(ii);
+						UsedCount++;
 					}
 					file.EndObject();
 				}
@@ -1354,6 +1451,9 @@ void ACSStringPool::ReadStrings(FSerializer &file, const char *key)
 		}
 	}
 
+	unsigned int numbuckets = MIN_BUCKETS;
+	while (numbuckets < UsedCount) numbuckets *= 2;
+	if (numbuckets != Buckets.Size()) Rehash(numbuckets);
 	FindFirstFreeEntry(FirstFreeEntry);
 }
 
@@ -1472,7 +1572,7 @@ void P_MarkGlobalVarStrings()
 //
 //============================================================================
 
-void P_CollectACSGlobalStrings()
+void P_CollectACSGlobalStrings(bool young)
 {
 	for (FACSStack *stack = FACSStack::head; stack != NULL; stack = stack->next)
 	{
@@ -1494,7 +1594,7 @@ void P_CollectACSGlobalStrings()
 	FBehavior::StaticMarkLevelVarStrings();
 	P_MarkWorldVarStrings();
 	P_MarkGlobalVarStrings();
-	GlobalACSStrings.PurgeStrings();
+	GlobalACSStrings.PurgeStrings(young);
 }
 
 #ifdef _DEBUG
@@ -2264,7 +2364,7 @@ FBehavior::FBehavior()
 	memset (MapVarStore, 0, sizeof(MapVarStore));
 	ModuleName[0] = 0;
 	FunctionProfileData = NULL;
-
+	JitModule = NULL;
 }
 	
 	
@@ -2761,6 +2861,11 @@ FBehavior::~FBehavior ()
 		delete[] FunctionProfileData;
 		FunctionProfileData = NULL;
 	}
+	if (JitModule != NULL)
+	{
+		delete JitModule;
+		JitModule = NULL;
+	}
 	if (Data != NULL)
 	{
 		delete[] Data;
@@ -3290,6 +3395,15 @@ const char *FBehavior::LookupString (uint32_t index) const
 	}
 }
 
+FACSJitModule *FBehavior::GetJitModule ()
+{
+	if (JitModule == NULL)
+	{
+		JitModule = new FACSJitModule;
+	}
+	return JitModule;
+}
+
 void FBehavior::StaticStartTypedScripts (uint16_t type, AActor *activator, bool always, int arg1, bool runNow)
 {
 	static const char *const TypeNames[] =
@@ -3465,7 +3579,17 @@ void DACSThinker::Tick ()
 	while (script)
 	{
 		DLevelScript *next = script->next;
-		script->RunScript ();
+		if (!ThinkerProfiler.IsRecording())
+		{
+			script->RunScript ();
+		}
+		else
+		{
+			int number = script->script;
+			uint64_t start = I_nsTime();
+			script->RunScript ();
+			ThinkerProfiler.AddScript(number, ScriptPresentation, I_nsTime() - start);
+		}
 		script = next;
 	}
 
@@ -6852,6 +6976,209 @@ static bool CharArrayParms(int &capacity, int &offset, int &a, FACSStackMemory&
 	return true;
 }
 
+//==========================================================================
+//
+// ACS region compiler
+//
+// Decodes the pcodes starting at a hot branch target for ACSJitCompile,
+// until the first one it has no native version of. Only pure stack,
+// arithmetic, variable and branch pcodes are handled; everything that
+// touches the game, strings or arrays stays with the interpreter.
+//
+//==========================================================================
+
+CVAR(Bool, acs_jit, false, 0)
+
+enum
+{
+	ACSJIT_HOT = 16,			// times a branch target has to be reached before it gets compiled
+	ACSJIT_MAXOPS = 256,
+	ACS_RUNAWAY = 2000000,		// instructions a script may execute in one tic
+};
+
+// Scripts can run other scripts immediately, which must not be timed twice.
+static int ACSRunDepth;
+
+static FACSJitRegion *CompileACSRegion(FBehavior *module, uint32_t start)
+{
+	ACSFormat fmt = module->GetFormat();
+	int *pc = module->Ofs2PC(start);
+	TArray<FACSJitOp> ops;
+	uint32_t offset;
+
+	for (;;)
+	{
+		// The longest pcode handled here is CASEGOTO, with 3 words.
+		offset = module->PC2Ofs(pc);
+		if (ops.Size() >= ACSJIT_MAXOPS || offset + 12 > (uint32_t)module->GetDataSize())
+		{
+			break;
+		}
+
+		int pcd;
+		if (fmt == ACS_LittleEnhanced)
+		{
+			pcd = getbyte(pc);
+			if (pcd >= 256-16)
+			{
+				pcd = (256-16) + ((pcd - (256-16)) << 8) + getbyte(pc);
+			}
+		}
+		else
+		{
+			pcd = NEXTWORD;
+		}
+
+		FACSJitOp op = { AJ_PushConst, 0, nullptr, offset, 0 };
+		int index;
+
+		switch (pcd)
+		{
+		case PCD_NOP:			continue;
+		case PCD_PUSHNUMBER:	op.Arg = uallong(pc[0]); pc++; break;
+		case PCD_PUSHBYTE:		op.Arg = *(uint8_t *)pc; pc = (int *)((uint8_t *)pc + 1); break;
+
+		case PCD_PUSH2BYTES:
+		case PCD_PUSH3BYTES:
+		case PCD_PUSH4BYTES:
+		case PCD_PUSH5BYTES:
+		case PCD_PUSHBYTES:
+		{
+			int count = pcd == PCD_PUSHBYTES ? getbyte(pc) : pcd - PCD_PUSH2BYTES + 2;
+			if (module->PC2Ofs(pc) + count > (uint32_t)module->GetDataSize())
+			{
+				goto done;
+			}
+			for (int i = 0; i < count; i++)
+			{
+				op.Arg = getbyte(pc);
+				ops.Push(op);
+			}
+			continue;
+		}
+
+		case PCD_DROP:			op.Op = AJ_Drop; break;
+		case PCD_DUP:			op.Op = AJ_Dup; break;
+		case PCD_SWAP:			op.Op = AJ_Swap; break;
+		case PCD_ADD:			op.Op = AJ_Add; break;
+		case PCD_SUBTRACT:		op.Op = AJ_Sub; break;
+		case PCD_MULTIPLY:		op.Op = AJ_Mul; break;
+		case PCD_DIVIDE:		op.Op = AJ_Div; break;
+		case PCD_MODULUS:		op.Op = AJ_Mod; break;
+		case PCD_EQ:			op.Op = AJ_EQ; break;
+		case PCD_NE:			op.Op = AJ_NE; break;
+		case PCD_LT:			op.Op = AJ_LT; break;
+		case PCD_GT:			op.Op = AJ_GT; break;
+		case PCD_LE:			op.Op = AJ_LE; break;
+		case PCD_GE:			op.Op = AJ_GE; break;
+		case PCD_ANDLOGICAL:	op.Op = AJ_LogAnd; break;
+		case PCD_ORLOGICAL:		op.Op = AJ_LogOr; break;
+		case PCD_ANDBITWISE:	op.Op = AJ_BitAnd; break;
+		case PCD_ORBITWISE:		op.Op = AJ_BitOr; break;
+		case PCD_EORBITWISE:	op.Op = AJ_BitXor; break;
+		case PCD_LSHIFT:		op.Op = AJ_LShift; break;
+		case PCD_RSHIFT:		op.Op = AJ_RShift; break;
+		case PCD_UNARYMINUS:	op.Op = AJ_Neg; break;
+		case PCD_NEGATELOGICAL:	op.Op = AJ_LogNot; break;
+		case PCD_NEGATEBINARY:	op.Op = AJ_BitNot; break;
+
+		case PCD_PUSHSCRIPTVAR:		op.Op = AJ_PushLocal; op.Arg = NEXTBYTE; break;
+		case PCD_ASSIGNSCRIPTVAR:	op.Op = AJ_AssignLocal; op.Arg = NEXTBYTE; break;
+		case PCD_ADDSCRIPTVAR:		op.Op = AJ_AddLocal; op.Arg = NEXTBYTE; break;
+		case PCD_SUBSCRIPTVAR:		op.Op = AJ_SubLocal; op.Arg = NEXTBYTE; break;
+		case PCD_INCSCRIPTVAR:		op.Op = AJ_IncLocal; op.Arg = NEXTBYTE; break;
+		case PCD_DECSCRIPTVAR:		op.Op = AJ_DecLocal; op.Arg = NEXTBYTE; break;
+
+		case PCD_PUSHMAPVAR:	case PCD_PUSHWORLDVAR:	case PCD_PUSHGLOBALVAR:		op.Op = AJ_PushVar; goto variable;
+		case PCD_ASSIGNMAPVAR:	case PCD_ASSIGNWORLDVAR:	case PCD_ASSIGNGLOBALVAR:	op.Op = AJ_AssignVar; goto variable;
+		case PCD_ADDMAPVAR:		case PCD_ADDWORLDVAR:	case PCD_ADDGLOBALVAR:		op.Op = AJ_AddVar; goto variable;
+		case PCD_SUBMAPVAR:		case PCD_SUBWORLDVAR:	case PCD_SUBGLOBALVAR:		op.Op = AJ_SubVar; goto variable;
+		case PCD_INCMAPVAR:		case PCD_INCWORLDVAR:	case PCD_INCGLOBALVAR:		op.Op = AJ_IncVar; goto variable;
+		case PCD_DECMAPVAR:		case PCD_DECWORLDVAR:	case PCD_DECGLOBALVAR:		op.Op = AJ_DecVar; goto variable;
+		variable:
+			// Out of range indices are left to the interpreter, which reports them.
+			index = NEXTBYTE;
+			switch (pcd)
+			{
+			case PCD_PUSHMAPVAR: case PCD_ASSIGNMAPVAR: case PCD_ADDMAPVAR:
+			case PCD_SUBMAPVAR: case PCD_INCMAPVAR: case PCD_DECMAPVAR:
+				op.Var = index < NUM_MAPVARS ? module->MapVars[index] : nullptr;
+				break;
+
+			case PCD_PUSHWORLDVAR: case PCD_ASSIGNWORLDVAR: case PCD_ADDWORLDVAR:
+			case PCD_SUBWORLDVAR: case PCD_INCWORLDVAR: case PCD_DECWORLDVAR:
+				op.Var = index < NUM_WORLDVARS ? &ACS_WorldVars[index] : nullptr;
+				break;
+
+			default:
+				op.Var = index < NUM_GLOBALVARS ? &ACS_GlobalVars[index] : nullptr;
+				break;
+			}
+			if (op.Var == nullptr) goto done;
+			break;
+
+		case PCD_GOTO:			op.Op = AJ_Goto; op.Target = LittleLong(*pc); pc++; break;
+		case PCD_IFGOTO:		op.Op = AJ_IfGoto; op.Target = LittleLong(*pc); pc++; break;
+		case PCD_IFNOTGOTO:		op.Op = AJ_IfNotGoto; op.Target = LittleLong(*pc); pc++; break;
+		case PCD_CASEGOTO:		op.Op = AJ_CaseGoto; op.Arg = uallong(pc[0]); op.Target = uallong(pc[1]); pc += 2; break;
+
+		default:
+			goto done;
+		}
+		ops.Push(op);
+	}
+done:
+	return ACSJitCompile(ops, offset);
+}
+
+//==========================================================================
+//
+// Called by the interpreter after every branch. Runs the compiled region
+// starting at pc, if there is one, and returns where to continue.
+//
+//==========================================================================
+
+static int *EnterACSRegion(FBehavior *module, int *pc, FACSStackMemory &Stack, int &sp, ACSLocalVariables &locals, unsigned int &runaway)
+{
+	FACSJitEntry &entry = module->GetJitModule()->Entries[module->PC2Ofs(pc)];
+	if (entry.Region == nullptr)
+	{
+		if (entry.Failed || ++entry.Heat < ACSJIT_HOT)
+		{
+			return pc;
+		}
+		entry.Region = CompileACSRegion(module, module->PC2Ofs(pc));
+		if (entry.Region == nullptr)
+		{
+			entry.Failed = true;
+			ACSJitStats.Rejected++;
+			return pc;
+		}
+		ACSJitStats.Compiled++;
+	}
+
+	FACSJitRegion *region = entry.Region;
+	if (sp + region->MinDepth < 0 || sp + region->MaxDepth > STACK_SIZE || locals.GetCount() < (size_t)region->NumLocals || runaway >= ACS_RUNAWAY)
+	{
+		return pc;
+	}
+
+	int32_t budget = ACS_RUNAWAY - runaway;
+	int32_t startbudget = budget;
+
+	ACSJitStats.Entries++;
+	ACSJitStats.JitCycles.Clock();
+	int exit = region->Entry(Stack.Pointer() + sp, locals.GetPointer(), &budget);
+	ACSJitStats.JitCycles.Unclock();
+
+	runaway += startbudget - budget;
+	sp += region->Exits[exit].Depth;
+	return module->Ofs2PC(region->Exits[exit].Offset);
+}
+
+// Both edges of a conditional branch are candidates, since loops are entered by falling through.
+#define ACSJIT_BRANCH	if (acs_jit) pc = EnterACSRegion(activeBehavior, pc, Stack, sp, locals, runaway)
+
 int DLevelScript::RunScript ()
 {
 	DACSThinker *controller = DACSThinker::ActiveThinker;
@@ -6942,9 +7269,11 @@ int DLevelScript::RunScript ()
 	int optstart = -1;
 	int temp;
 
+	if (ACSRunDepth++ == 0) ACSJitStats.RunCycles.Clock();
+
 	while (state == SCRIPT_Running)
 	{
-		if (++runaway > 2000000)
+		if (++runaway > ACS_RUNAWAY)
 		{
 			Printf ("Runaway %s terminated\n", ScriptPresentation(script).GetChars());
 			state = SCRIPT_PleaseRemove;
@@ -8179,6 +8508,7 @@ int DLevelScript::RunScript ()
 
 		case PCD_GOTO:
 			pc = activeBehavior->Ofs2PC (LittleLong(*pc));
+			ACSJIT_BRANCH;
 			break;
 
 		case PCD_GOTOSTACK:
@@ -8192,6 +8522,7 @@ int DLevelScript::RunScript ()
 			else
 				pc++;
 			sp--;
+			ACSJIT_BRANCH;
 			break;
 
 		case PCD_SETRESULTVALUE:
@@ -8376,6 +8707,7 @@ int DLevelScript::RunScript ()
 			else
 				pc++;
 			sp--;
+			ACSJIT_BRANCH;
 			break;
 
 		case PCD_LINESIDE:
@@ -8416,6 +8748,7 @@ scriptwait:
 			{
 				pc = activeBehavior->Ofs2PC (uallong(pc[1]));
 				sp--;
+				ACSJIT_BRANCH;
 			}
 			else
 			{
@@ -10267,6 +10600,8 @@ scriptwait:
  		}
  	}
 
+	if (--ACSRunDepth == 0) ACSJitStats.RunCycles.Unclock();
+
 	if (runaway != 0 && InModuleScriptNumber >= 0)
 	{
 		auto scriptptr = activeBehavior->GetScriptPtr(InModuleScriptNumber);
@@ -10794,6 +11129,7 @@ CCMD(acsprofile)
 		{
 			ClearProfiles(ScriptProfiles);
 			ClearProfiles(FuncProfiles);
+			ACSJitStats.Clear();
 			return;
 		}
 		for (int i = 1; i < argv.argc(); ++i)
@@ -10834,9 +11170,18 @@ CCMD(acsprofile)
 
 	ShowProfileData(ScriptProfiles, limit, sorter, false);
 	ShowProfileData(FuncProfiles, limit, sorter, true);
+
+	double jitms = ACSJitStats.JitCycles.TimeMS();
+	Printf(TEXTCOLOR_ORANGE "Execution time:\n");
+	Printf("Interpreted %.3f ms, compiled %.3f ms\n", ACSJitStats.RunCycles.TimeMS() - jitms, jitms);
+	Printf("%u regions compiled, %u rejected, %llu entries%s\n", ACSJitStats.Compiled, ACSJitStats.Rejected,
+		(unsigned long long)ACSJitStats.Entries, acs_jit ? "" : " (acs_jit is off)");
 }
 
 ADD_STAT(ACS)
 {
-	return FStringf("ACS time: %f ms", ACSTime.TimeMS());
+	auto &stats = GlobalACSStrings.Stats;
+	return FStringf("ACS time: %f ms\nStrings: %u in %u slots, %u buckets, %u lookups (%.1f%% found), %u young/%u full collections, %u freed",
+		ACSTime.TimeMS(), GlobalACSStrings.CountUsed(), GlobalACSStrings.CountSlots(), GlobalACSStrings.CountBuckets(),
+		stats.Lookups, stats.Lookups ? stats.Found * 100. / stats.Lookups : 0., stats.YoungCollections, stats.FullCollections, stats.Freed);
 }
@@ -110,40 +110,63 @@ public:
 	void UnlockStringArray(const int *strnum, unsigned int count);
 	void MarkStringArray(const int *strnum, unsigned int count);
 	void MarkStringMap(const FWorldGlobalArray &array);
-	void PurgeStrings();
+	void PurgeStrings(bool young = false);
 	void Clear();
 	void Dump() const;
 	void UnlockForLevel(int level)	;
 	void ReadStrings(FSerializer &file, const char *key);
 	void WriteStrings(FSerializer &file, const char *key) const;
 
+	unsigned int CountUsed() const { return UsedCount; }
+	unsigned int CountSlots() const { return Pool.Size(); }
+	unsigned int CountBuckets() const { return Buckets.Size(); }
+
+	struct FStats
+	{
+		unsigned int Lookups = 0;
+		unsigned int Found = 0;
+		unsigned int YoungCollections = 0;
+		unsigned int FullCollections = 0;
+		unsigned int Freed = 0;
+	};
+	FStats Stats;
+
 private:
-	int FindString(const char *str, size_t len, unsigned int h, unsigned int bucketnum);
-	int InsertString(FString &str, unsigned int h, unsigned int bucketnum);
+	int FindString(const char *str, size_t len, unsigned int h);
+	int InsertString(FString &str, unsigned int h);
 	void FindFirstFreeEntry(unsigned int base);
+	void FreeEntry(unsigned int index);
+	void LinkEntry(unsigned int index);
+	void UnlinkEntry(unsigned int index);
+	void Rehash(unsigned int numbuckets);
 
-	enum { NUM_BUCKETS = 251 };
+	enum { MIN_BUCKETS = 256 };			// Must be a power of 2
 	enum { FREE_ENTRY = 0xFFFFFFFE };	// Stored in PoolEntry's Next field
 	enum { NO_ENTRY = 0xFFFFFFFF };
 	enum { MIN_GC_SIZE = 100 };			// Don't auto-collect until there are this many strings
+	enum { YOUNG_GCS = 8 };				// Automatic collections that only look at new strings before a full one is done
 	struct PoolEntry
 	{
 		FString Str;
 		unsigned int Hash;
 		unsigned int Next = FREE_ENTRY;
-		bool Mark;
+		unsigned int MarkEpoch = 0;		// marked for the collection with this epoch
 		TArray<int> Locks;
 
 		void Lock();
 		void Unlock();
 	};
 	TArray<PoolEntry> Pool;
-	unsigned int PoolBuckets[NUM_BUCKETS];
+	TArray<unsigned int> Buckets;
+	TArray<unsigned int> Young;			// entries added since the last collection
 	unsigned int FirstFreeEntry;
+	unsigned int UsedCount;
+	unsigned int Epoch;
+	unsigned int YoungSinceFull;
 };
 extern ACSStringPool GlobalACSStrings;
 
-void P_CollectACSGlobalStrings();
+void P_CollectACSGlobalStrings(bool young = false);
 void P_ReadACSVars(FSerializer &);
 void P_WriteACSVars(FSerializer &);
 void P_ClearACSVars(bool);
@@ -200,6 +223,16 @@ public:
 		return memory;
 	}
 
+	int32_t *GetPointer()
+	{
+		return memory;
+	}
+
+	size_t GetCount() const
+	{
+		return count;
+	}
+
 private:
 	int32_t *memory;
 	size_t count;
@@ -344,6 +377,8 @@ enum
 
 enum ACSFormat { ACS_Old, ACS_Enhanced, ACS_LittleEnhanced, ACS_Unknown };
 
+struct FACSJitModule;
+
 class FBehavior
 {
 public:
@@ -378,6 +413,7 @@ public:
 	ACSProfileInfo *GetFunctionProfileData(int index) { return index >= 0 && index < NumFunctions ? &FunctionProfileData[index] : NULL; }
 	ACSProfileInfo *GetFunctionProfileData(ScriptFunction *func) { return GetFunctionProfileData((int)(func - (ScriptFunction *)Functions)); }
 	const char *LookupString (uint32_t index) const;
+	FACSJitModule *GetJitModule ();
 
 	BoundsCheckingArray<int32_t *, NUM_MAPVARS> MapVars;
 
@@ -420,6 +456,7 @@ private:
 	uint32_t LibraryID;
 	char ModuleName[9];
 	TArray<int> JumpPoints;
+	FACSJitModule *JitModule;
 
 	static TArray<FBehavior *> StaticModules;
 
@@ -0,0 +1,425 @@
+//
+//---------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//--------------------------------------------------------------------------
+//
+
+#include "p_acsjit.h"
+#include "jitintern.h"
+#include "templates.h"
+
+FACSJitStats ACSJitStats;
+
+// Regions neither call out nor throw, so unlike script functions they need
+// no unwind information and can live in asmjit's own runtime, which allows
+// releasing them when their module is unloaded.
+static asmjit::JitRuntime ACSJitRuntime;
+
+namespace
+{
+	struct FStackEffect
+	{
+		int8_t Pops;
+		int8_t Pushes;
+	};
+
+	const FStackEffect Effects[] =
+	{
+		{ 0, 1 },	// AJ_PushConst
+		{ 1, 0 },	// AJ_Drop
+		{ 1, 2 },	// AJ_Dup
+		{ 2, 2 },	// AJ_Swap
+
+		{ 2, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 },				// Add, Sub, Mul, Div, Mod
+		{ 2, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 },	// EQ, NE, LT, GT, LE, GE
+		{ 2, 1 }, { 2, 1 },												// LogAnd, LogOr
+		{ 2, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 }, { 2, 1 },				// BitAnd, BitOr, BitXor, LShift, RShift
+		{ 1, 1 }, { 1, 1 }, { 1, 1 },									// Neg, LogNot, BitNot
+
+		{ 0, 1 }, { 1, 0 }, { 1, 0 }, { 1, 0 }, { 0, 0 }, { 0, 0 },	// locals
+		{ 0, 1 }, { 1, 0 }, { 1, 0 }, { 1, 0 }, { 0, 0 }, { 0, 0 },	// variables
+
+		{ 0, 0 },	// AJ_Goto
+		{ 1, 0 },	// AJ_IfGoto
+		{ 1, 0 },	// AJ_IfNotGoto
+		{ 1, 1 },	// AJ_CaseGoto, pops only when taken
+	};
+
+	static_assert(countof(Effects) == AJ_CaseGoto + 1, "Stack effect table does not match EACSJitOp");
+
+	bool IsBranch(EACSJitOp op)
+	{
+		return op >= AJ_Goto;
+	}
+
+	bool IsLocal(EACSJitOp op)
+	{
+		return op >= AJ_PushLocal && op <= AJ_DecLocal;
+	}
+}
+
+//==========================================================================
+//
+// Every operation needs a stack depth that is the same on all paths
+// leading to it. The region is cut at the first operation where that is
+// not the case or that can only be reached by a later backward branch.
+// Branches out of the region or into a mismatching depth become exits.
+// A pcode can expand to several operations with the same offset (the
+// PUSHnBYTES family). Branches and exits can only resume the interpreter
+// at a pcode's start, so such a group is never cut in the middle.
+//
+//==========================================================================
+
+static int AnalyzeRegion(const TArray<FACSJitOp> &ops, TArray<int> &depth, TArray<int> &target, FACSJitRegion *region)
+{
+	const int unknown = INT_MIN;
+	int numops = ops.Size();
+
+	depth.Resize(numops);
+	target.Resize(numops);
+	for (int i = 0; i < numops; i++)
+	{
+		depth[i] = unknown;
+		target[i] = -1;
+	}
+
+	// Branches go to the first operation of a pcode.
+	TMap<uint32_t, int> index;
+	for (int i = 0; i < numops; i++)
+	{
+		if (!index.CheckKey(ops[i].Offset)) index[ops[i].Offset] = i;
+	}
+	auto groupstart = [&](int i)
+	{
+		while (i > 0 && ops[i - 1].Offset == ops[i].Offset) i--;
+		return i;
+	};
+
+	region->MinDepth = region->MaxDepth = region->NumLocals = 0;
+	depth[0] = 0;
+
+	for (int i = 0; i < numops; i++)
+	{
+		if (depth[i] == unknown)
+		{
+			numops = groupstart(i);
+			break;
+		}
+
+		auto &op = ops[i];
+		int d = depth[i];
+		int after = d - Effects[op.Op].Pops + Effects[op.Op].Pushes;
+		region->MinDepth = MIN(region->MinDepth, d - Effects[op.Op].Pops);
+		region->MaxDepth = MAX(region->MaxDepth, MAX(d, after));
+		if (IsLocal(op.Op)) region->NumLocals = MAX(region->NumLocals, op.Arg + 1);
+
+		if (IsBranch(op.Op))
+		{
+			int taken = op.Op == AJ_CaseGoto ? d - 1 : after;
+			int *t = index.CheckKey(op.Target);
+			if (t != nullptr)
+			{
+				if (*t > i && depth[*t] == unknown) depth[*t] = taken;
+				if (depth[*t] == taken) target[i] = *t;
+			}
+		}
+
+		if (op.Op != AJ_Goto && i + 1 < numops)
+		{
+			if (depth[i + 1] == unknown) depth[i + 1] = after;
+			else if (depth[i + 1] != after)
+			{
+				numops = ops[i + 1].Offset == op.Offset ? groupstart(i) : i + 1;
+				break;
+			}
+		}
+	}
+	return numops;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FACSJitRegion *ACSJitCompile(const TArray<FACSJitOp> &ops, uint32_t endoffset)
+{
+	using namespace asmjit;
+
+	if (ops.Size() == 0) return nullptr;
+
+	auto region = new FACSJitRegion;
+	TArray<int> depth, target;
+	int numops = AnalyzeRegion(ops, depth, target, region);
+	if (numops == 0)
+	{
+		delete region;
+		return nullptr;
+	}
+
+	try
+	{
+		ThrowingErrorHandler errorHandler;
+		CodeHolder code;
+		code.init(ACSJitRuntime.getCodeInfo());
+		code.setErrorHandler(&errorHandler);
+
+		X86Compiler cc(&code);
+		X86Gp stack = cc.newIntPtr("stack");
+		X86Gp locals = cc.newIntPtr("locals");
+		X86Gp budget = cc.newIntPtr("budget");
+		X86Gp a = cc.newInt32("a");
+		X86Gp b = cc.newInt32("b");
+		X86Gp r = cc.newInt32("r");
+		X86Gp var = cc.newIntPtr("var");
+
+		cc.addFunc(FuncSignature3<int, void *, void *, void *>());
+		cc.setArg(0, stack);
+		cc.setArg(1, locals);
+		cc.setArg(2, budget);
+
+		TArray<Label> labels, exitlabels;
+		for (int i = 0; i < numops; i++) labels.Push(cc.newLabel());
+
+		auto exitTo = [&](uint32_t offset, int d)
+		{
+			region->Exits.Push({ offset, d });
+			return exitlabels[exitlabels.Push(cc.newLabel())];
+		};
+
+		// STACK(n) in the interpreter's terms, at depth d.
+		auto slot = [&](int d, int n) { return x86::dword_ptr(stack, (d - n) * 4); };
+		auto local = [&](int index) { return x86::dword_ptr(locals, index * 4); };
+
+		auto jumpTo = [&](int i, uint32_t offset, int d)
+		{
+			int t = target[i];
+			if (t < 0 || t >= numops)
+			{
+				cc.jmp(exitTo(offset, d));
+			}
+			else if (t > i)
+			{
+				cc.jmp(labels[t]);
+			}
+			else
+			{
+				// Loops are charged their length on every iteration, so the interpreter's runaway check still applies.
+				cc.sub(x86::dword_ptr(budget), i - t + 1);
+				cc.jle(exitTo(offset, d));
+				cc.jmp(labels[t]);
+			}
+		};
+
+		for (int i = 0; i < numops; i++)
+		{
+			auto &op = ops[i];
+			int d = depth[i];
+
+			cc.bind(labels[i]);
+
+			if (op.Op >= AJ_Add && op.Op <= AJ_RShift)
+			{
+				cc.mov(a, slot(d, 2));
+				cc.mov(b, slot(d, 1));
+			}
+			else if (op.Op >= AJ_Neg && op.Op <= AJ_BitNot)
+			{
+				cc.mov(a, slot(d, 1));
+			}
+			else if (op.Op >= AJ_PushVar && op.Op <= AJ_DecVar)
+			{
+				cc.mov(var, imm_ptr(op.Var));
+			}
+
+			switch (op.Op)
+			{
+			case AJ_PushConst:	cc.mov(slot(d, 0), op.Arg); break;
+			case AJ_Drop:		break;
+			case AJ_Dup:		cc.mov(a, slot(d, 1)); cc.mov(slot(d, 0), a); break;
+			case AJ_Swap:
+				cc.mov(a, slot(d, 2));
+				cc.mov(b, slot(d, 1));
+				cc.mov(slot(d, 2), b);
+				cc.mov(slot(d, 1), a);
+				break;
+
+			case AJ_Add:		cc.add(a, b); break;
+			case AJ_Sub:		cc.sub(a, b); break;
+			case AJ_Mul:		cc.imul(a, b); break;
+			case AJ_BitAnd:		cc.and_(a, b); break;
+			case AJ_BitOr:		cc.or_(a, b); break;
+			case AJ_BitXor:		cc.xor_(a, b); break;
+			case AJ_LShift:		cc.shl(a, b); break;
+			case AJ_RShift:		cc.sar(a, b); break;
+
+			case AJ_Div:
+			case AJ_Mod:
+				// Let the interpreter report the division by zero.
+				cc.test(b, b);
+				cc.je(exitTo(op.Offset, d));
+				cc.cdq(r, a);
+				cc.idiv(r, a, b);
+				if (op.Op == AJ_Mod) cc.mov(a, r);
+				break;
+
+			case AJ_EQ: case AJ_NE: case AJ_LT: case AJ_GT: case AJ_LE: case AJ_GE:
+			{
+				static const uint32_t conds[] = { x86::kCondE, x86::kCondNE, x86::kCondL, x86::kCondG, x86::kCondLE, x86::kCondGE };
+				cc.xor_(r, r);
+				cc.cmp(a, b);
+				cc.mov(a, 1);
+				cc.cmov(conds[op.Op - AJ_EQ], r, a);
+				cc.mov(a, r);
+				break;
+			}
+
+			case AJ_LogAnd:
+			{
+				Label done = cc.newLabel();
+				cc.xor_(r, r);
+				cc.test(a, a);
+				cc.je(done);
+				cc.test(b, b);
+				cc.je(done);
+				cc.mov(r, 1);
+				cc.bind(done);
+				cc.mov(a, r);
+				break;
+			}
+
+			case AJ_LogOr:
+				cc.xor_(r, r);
+				cc.or_(a, b);
+				cc.mov(a, 1);
+				cc.cmovne(r, a);
+				cc.mov(a, r);
+				break;
+
+			case AJ_Neg:		cc.neg(a); break;
+			case AJ_BitNot:		cc.not_(a); break;
+			case AJ_LogNot:
+				cc.xor_(r, r);
+				cc.test(a, a);
+				cc.mov(a, 1);
+				cc.cmove(r, a);
+				cc.mov(a, r);
+				break;
+
+			case AJ_PushLocal:	cc.mov(a, local(op.Arg)); cc.mov(slot(d, 0), a); break;
+			case AJ_AssignLocal: cc.mov(a, slot(d, 1)); cc.mov(local(op.Arg), a); break;
+			case AJ_AddLocal:	cc.mov(a, slot(d, 1)); cc.add(local(op.Arg), a); break;
+			case AJ_SubLocal:	cc.mov(a, slot(d, 1)); cc.sub(local(op.Arg), a); break;
+			case AJ_IncLocal:	cc.add(local(op.Arg), 1); break;
+			case AJ_DecLocal:	cc.sub(local(op.Arg), 1); break;
+
+			case AJ_PushVar:	cc.mov(a, x86::dword_ptr(var)); cc.mov(slot(d, 0), a); break;
+			case AJ_AssignVar:	cc.mov(a, slot(d, 1)); cc.mov(x86::dword_ptr(var), a); break;
+			case AJ_AddVar:		cc.mov(a, slot(d, 1)); cc.add(x86::dword_ptr(var), a); break;
+			case AJ_SubVar:		cc.mov(a, slot(d, 1)); cc.sub(x86::dword_ptr(var), a); break;
+			case AJ_IncVar:		cc.add(x86::dword_ptr(var), 1); break;
+			case AJ_DecVar:		cc.sub(x86::dword_ptr(var), 1); break;
+
+			case AJ_Goto:
+				jumpTo(i, op.Target, d);
+				break;
+
+			case AJ_IfGoto:
+			case AJ_IfNotGoto:
+			{
+				Label skip = cc.newLabel();
+				cc.cmp(slot(d, 1), 0);
+				if (op.Op == AJ_IfGoto) cc.je(skip);
+				else cc.jne(skip);
+				jumpTo(i, op.Target, d - 1);
+				cc.bind(skip);
+				break;
+			}
+
+			case AJ_CaseGoto:
+			{
+				Label skip = cc.newLabel();
+				cc.cmp(slot(d, 1), op.Arg);
+				cc.jne(skip);
+				jumpTo(i, op.Target, d - 1);
+				cc.bind(skip);
+				break;
+			}
+			}
+
+			if ((op.Op >= AJ_Add && op.Op <= AJ_RShift) || (op.Op >= AJ_Neg && op.Op <= AJ_BitNot))
+			{
+				cc.mov(slot(d, Effects[op.Op].Pops), a);
+			}
+		}
+
+		auto &last = ops[numops - 1];
+		if (last.Op != AJ_Goto)
+		{
+			uint32_t offset = numops < (int)ops.Size() ? ops[numops].Offset : endoffset;
+			cc.jmp(exitTo(offset, depth[numops - 1] - Effects[last.Op].Pops + Effects[last.Op].Pushes));
+		}
+
+		for (unsigned i = 0; i < exitlabels.Size(); i++)
+		{
+			cc.bind(exitlabels[i]);
+			cc.mov(r, (int)i);
+			cc.ret(r);
+		}
+
+		cc.endFunc();
+		cc.finalize();
+
+		if (ACSJitRuntime.add(&region->Entry, &code) != kErrorOk)
+		{
+			delete region;
+			return nullptr;
+		}
+	}
+	catch (const std::exception &e)
+	{
+		DPrintf(DMSG_WARNING, "ACS JIT error: %s\n", e.what());
+		delete region;
+		return nullptr;
+	}
+	return region;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void ACSJitRelease(FACSJitRegion *region)
+{
+	if (region != nullptr)
+	{
+		ACSJitRuntime.release(region->Entry);
+		delete region;
+	}
+}
+
+FACSJitModule::~FACSJitModule()
+{
+	TMap<uint32_t, FACSJitEntry>::Iterator it(Entries);
+	TMap<uint32_t, FACSJitEntry>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		ACSJitRelease(pair->Value.Region);
+	}
+}
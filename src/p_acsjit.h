@@ -0,0 +1,130 @@
+#pragma once
+
+//
+//---------------------------------------------------------------------------
+//
+// ACS region compiler
+//
+// Hot branch targets in ACS bytecode are decoded into a short list of
+// simple stack operations (see CompileACSRegion in p_acs.cpp), which is
+// compiled here to native code. A region runs until it reaches a pcode it
+// does not handle, leaves its own range or runs out of instruction budget,
+// and then hands the interpreter the pcode offset and stack depth to
+// continue from.
+//
+//---------------------------------------------------------------------------
+//
+
+#include "tarray.h"
+#include "stats.h"
+
+enum EACSJitOp
+{
+	AJ_PushConst,		// Arg = value
+	AJ_Drop,
+	AJ_Dup,
+	AJ_Swap,
+
+	AJ_Add,
+	AJ_Sub,
+	AJ_Mul,
+	AJ_Div,
+	AJ_Mod,
+	AJ_EQ,
+	AJ_NE,
+	AJ_LT,
+	AJ_GT,
+	AJ_LE,
+	AJ_GE,
+	AJ_LogAnd,
+	AJ_LogOr,
+	AJ_BitAnd,
+	AJ_BitOr,
+	AJ_BitXor,
+	AJ_LShift,
+	AJ_RShift,
+	AJ_Neg,
+	AJ_LogNot,
+	AJ_BitNot,
+
+	AJ_PushLocal,		// Arg = local variable index
+	AJ_AssignLocal,
+	AJ_AddLocal,
+	AJ_SubLocal,
+	AJ_IncLocal,
+	AJ_DecLocal,
+
+	AJ_PushVar,			// Var = address of a map, world or global variable
+	AJ_AssignVar,
+	AJ_AddVar,
+	AJ_SubVar,
+	AJ_IncVar,
+	AJ_DecVar,
+
+	AJ_Goto,			// Target = byte offset
+	AJ_IfGoto,
+	AJ_IfNotGoto,
+	AJ_CaseGoto,		// Arg = case value
+};
+
+struct FACSJitOp
+{
+	EACSJitOp Op;
+	int32_t Arg;
+	int32_t *Var;
+	uint32_t Offset;	// byte offset of the pcode in its module
+	uint32_t Target;
+};
+
+struct FACSJitExit
+{
+	uint32_t Offset;
+	int Depth;
+};
+
+struct FACSJitRegion
+{
+	// 'stack' points at the first free stack slot. 'budget' is decremented by
+	// the number of operations in a loop every time it branches back.
+	int (*Entry)(int32_t *stack, int32_t *locals, int32_t *budget);
+	int MinDepth;		// lowest stack slot touched, relative to the entry
+	int MaxDepth;
+	int NumLocals;
+	TArray<FACSJitExit> Exits;
+};
+
+struct FACSJitEntry
+{
+	int Heat = 0;
+	bool Failed = false;
+	FACSJitRegion *Region = nullptr;
+};
+
+// Per module bookkeeping, indexed by branch target offset.
+struct FACSJitModule
+{
+	~FACSJitModule();
+	TMap<uint32_t, FACSJitEntry> Entries;
+};
+
+struct FACSJitStats
+{
+	unsigned Compiled = 0;
+	unsigned Rejected = 0;
+	uint64_t Entries = 0;
+	cycle_t RunCycles;		// everything spent in RunScript
+	cycle_t JitCycles;		// the part of it spent in compiled regions
+
+	// Compiled regions stay around, so only the counters describing a run are reset.
+	void Clear()
+	{
+		Entries = 0;
+		RunCycles.Reset();
+		JitCycles.Reset();
+	}
+};
+
+extern FACSJitStats ACSJitStats;
+
+FACSJitRegion *ACSJitCompile(const TArray<FACSJitOp> &ops, uint32_t endoffset);
+void ACSJitRelease(FACSJitRegion *region);
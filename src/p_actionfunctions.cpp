@@ -1674,24 +1674,22 @@ DEFINE_ACTION_FUNCTION(AActor, CheckIfSeen)
 {
 	PARAM_SELF_PROLOGUE(AActor);
 
+	AActor *viewers[MAXPLAYERS * 2];
+	int count = 0;
 	for (int i = 0; i < MAXPLAYERS; i++) 
 	{
 		if (playeringame[i])
 		{
 			// Always check sight from each player.
-			if (P_CheckSight(players[i].mo, self, SF_IGNOREVISIBILITY))
-			{
-				ACTION_RETURN_BOOL(false);
-			}
+			viewers[count++] = players[i].mo;
 			// If a player is viewing from a non-player, then check that too.
-			if (players[i].camera != NULL && players[i].camera->player == NULL &&
-				P_CheckSight(players[i].camera, self, SF_IGNOREVISIBILITY))
+			if (players[i].camera != NULL && players[i].camera->player == NULL)
 			{
-				ACTION_RETURN_BOOL(false);
+				viewers[count++] = players[i].camera;
 			}
 		}
 	}
-	ACTION_RETURN_BOOL(true);
+	ACTION_RETURN_BOOL(P_CheckSightAny(viewers, count, self, SF_IGNOREVISIBILITY) < 0);
 }
 
 //===========================================================================
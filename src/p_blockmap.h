@@ -2,10 +2,13 @@
 #define __P_BLOCKMAP_H
 
 #include "doomtype.h"
+#include "tarray.h"
 
 class AActor;
 
 // [RH] Like msecnode_t, but for the blockmap
+// With flat thing lists only Me, BlockIndex and the per-actor block
+// chain are used; the block itself stores the actor in an array.
 struct FBlockNode
 {
 	AActor *Me;						// actor this node references
@@ -40,6 +43,7 @@ struct FBlockmap
 	double				bmaporgx;
 	double				bmaporgy;		// origin of block map
 	FBlockNode**		blocklinks; 	// for thing chains
+	TArray<AActor *>*	blockthings;	// flat thing lists, replace blocklinks if not null
 
 	// mapblocks are used to check movement
 	// against lines and things
@@ -75,6 +79,10 @@ struct FBlockmap
 
 	bool VerifyBlockMap(int count, unsigned numlines);
 
+	// Used by the FBlockNode chains to enter and leave the flat thing lists.
+	void LinkFlat(FBlockNode *node);
+	int UnlinkFlat(FBlockNode *node);
+
 	void Clear()
 	{
 		if (blockmaplump != NULL)
@@ -87,6 +95,11 @@ struct FBlockmap
 			delete[] blocklinks;
 			blocklinks = NULL;
 		}
+		if (blockthings != NULL)
+		{
+			delete[] blockthings;
+			blockthings = NULL;
+		}
 	}
 
 };
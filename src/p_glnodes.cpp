@@ -948,7 +948,7 @@ bool MapLoader::CheckNodes(MapData * map, bool rebuilt, int buildtime)
 typedef TArray<uint8_t> MemFile;
 
 
-static FString CreateCacheName(MapData *map, bool create)
+static FString CreateCacheName(MapData *map, bool create, const char *ext = ".gzc")
 {
 	FString path = M_GetCachePath(create);
 	FString lumpname = Wads.GetLumpFullPath(map->lumpnum);
@@ -958,7 +958,7 @@ static FString CreateCacheName(MapData *map, bool create)
 
 	lumpname.ReplaceChars('/', '%');
 	lumpname.ReplaceChars(':', '$');
-	path << '/' << lumpname.Right(lumpname.Len() - separator - 1) << ".gzc";
+	path << '/' << lumpname.Right(lumpname.Len() - separator - 1) << ext;
 	return path;
 }
 
@@ -1147,6 +1147,119 @@ bool MapLoader::CheckCachedNodes(MapData *map)
 	return true;
 }
 
+//==========================================================================
+//
+// Blockmap caching
+//
+// Generated blockmaps are stored uncompressed next to the cached nodes so
+// that they can be read back in a single block. The file is keyed on the
+// map checksum and the engine version, so a changed blockmap builder
+// never picks up stale data.
+//
+//==========================================================================
+
+static const uint32_t BLOCKMAP_CACHE_VERSION = 1;
+
+// Blockmaps of smaller maps are built faster than the cache can be opened.
+static const unsigned MIN_CACHED_BLOCKMAP_LINES = 4096;
+
+bool MapLoader::CheckCachedBlockMap(MapData *map)
+{
+	char magic[4];
+	uint32_t header[2];
+	uint8_t md5[16];
+	uint32_t len;
+	FString version;
+
+	if (!gl_cachenodes || Level->lines.Size() < MIN_CACHED_BLOCKMAP_LINES) return false;
+
+	// This may run on a worker thread, so it must not print anything or
+	// touch the map's lump reader.
+	FString path = CreateCacheName(map, false, ".gzb");
+	FileReader fr;
+
+	if (!fr.OpenFile(path)) return false;
+
+	if (fr.Read(magic, 4) != 4 || memcmp(magic, "BMAP", 4)) return false;
+	if (fr.Read(header, 8) != 8) return false;
+	if (LittleLong(header[0]) != BLOCKMAP_CACHE_VERSION || LittleLong(header[1]) != Level->lines.Size()) return false;
+	if (fr.Read(md5, 16) != 16 || memcmp(md5, Level->md5, 16)) return false;
+
+	if (fr.Read(&len, 4) != 4) return false;
+	len = LittleLong(len);
+	if (len > 256) return false;
+	version.LockNewBuffer(len);
+	bool ok = fr.Read(version.LockBuffer(), len) == len;
+	version.UnlockBuffer();
+	if (!ok || version.Compare(GetVersionString())) return false;
+
+	if (fr.Read(&len, 4) != 4) return false;
+	len = LittleLong(len);
+	if (len < 4 || len > 0x10000000) return false;
+
+	TArray<int> data(len, true);
+	if (fr.Read(data.Data(), len * 4) != len * 4) return false;
+	for (auto &v : data) v = LittleLong(v);
+
+	// Same checks as FBlockmap::VerifyBlockMap, minus the messages, so that
+	// a damaged file cannot crash the game.
+	if (data[2] <= 0 || data[3] <= 0) return false;
+	uint64_t numblocks = (uint64_t)data[2] * data[3];
+	if (numblocks + 4 > len) return false;
+
+	const unsigned numlines = Level->lines.Size();
+	for (unsigned i = 4; i < numblocks + 4; i++)
+	{
+		int offset = data[i];
+		if (offset < 4 || (unsigned)offset >= len) return false;
+		if (data[offset] != 0) return false;
+
+		unsigned j;
+		for (j = offset; j < len && data[j] != -1; j++)
+		{
+			if ((unsigned)data[j] >= numlines) return false;
+		}
+		if (j == len) return false;
+	}
+
+	Level->blockmap.blockmaplump = new int[len];
+	memcpy(Level->blockmap.blockmaplump, data.Data(), len * 4);
+	return true;
+}
+
+void MapLoader::CreateCachedBlockMap(MapData *map)
+{
+	if (!gl_cachenodes || Level->lines.Size() < MIN_CACHED_BLOCKMAP_LINES || CreatedBlockMapSize == 0) return;
+
+	MemFile out;
+	FString version = GetVersionString();
+
+	for (int i = 0; i < 4; i++) WriteByte(out, "BMAP"[i]);
+	WriteLong(out, BLOCKMAP_CACHE_VERSION);
+	WriteLong(out, Level->lines.Size());
+	for (int i = 0; i < 16; i++) WriteByte(out, Level->md5[i]);
+	WriteLong(out, (uint32_t)version.Len());
+	for (unsigned i = 0; i < version.Len(); i++) WriteByte(out, version[i]);
+	WriteLong(out, CreatedBlockMapSize);
+	for (unsigned i = 0; i < CreatedBlockMapSize; i++) WriteLong(out, Level->blockmap.blockmaplump[i]);
+
+	FString path = CreateCacheName(map, true, ".gzb");
+	FileWriter *fw = FileWriter::Open(path);
+
+	if (fw != nullptr)
+	{
+		if (fw->Write(out.Data(), out.Size()) != out.Size())
+		{
+			Printf("Error saving blockmap to file %s\n", path.GetChars());
+		}
+		delete fw;
+	}
+	else
+	{
+		Printf("Cannot open blockmap file %s for writing\n", path.GetChars());
+	}
+}
+
 UNSAFE_CCMD(clearnodecache)
 {
 	TArray<FFileList> list;
@@ -1164,7 +1277,8 @@ UNSAFE_CCMD(clearnodecache)
 	}
 
 	// Scan list backwards so that when we reach a directory
-	// all files within are already deleted.
+	// all files within are already deleted. This includes the
+	// subdirectories of other caches, like ZScript's token cache.
 	for(int i = list.Size()-1; i >= 0; i--)
 	{
 		if (list[i].isDirectory)
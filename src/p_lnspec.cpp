@@ -3937,6 +3937,8 @@ int P_ExecuteSpecial(int			num,
 {
 	if (num >= 0 && num < (int)countof(LineSpecials))
 	{
+		// Specials may change line flags, planes or polyobjects right away.
+		P_InvalidateSightCache();
 		return LineSpecials[num](line, activator, backSide, arg1, arg2, arg3, arg4, arg5);
 	}
 	return 0;
@@ -0,0 +1,211 @@
+//
+//---------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//--------------------------------------------------------------------------
+//
+
+#include <thread>
+#include <vector>
+#include "p_loadtasks.h"
+#include "ctpl.h"
+#include "i_time.h"
+#include "doomtype.h"
+#include "templates.h"
+
+//==========================================================================
+//
+// The pool is shared by everything the level loader runs in the background.
+//
+//==========================================================================
+
+ctpl::thread_pool &FLoadTaskGraph::Pool()
+{
+	static ctpl::thread_pool pool(MAX<int>(1, std::thread::hardware_concurrency() - 1));
+	return pool;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FLoadTaskGraph::~FLoadTaskGraph()
+{
+	// If an error unwinds past a started graph the workers may still be
+	// using the caller's data.
+	for (auto task : Tasks)
+	{
+		if (task->Done.valid()) task->Done.wait();
+	}
+	Clear();
+}
+
+void FLoadTaskGraph::Clear()
+{
+	for (auto task : Tasks)
+	{
+		delete task;
+	}
+	Tasks.Clear();
+}
+
+//==========================================================================
+//
+// Dependencies must refer to tasks that were added before, so the order
+// of insertion is always a valid serial order.
+//
+//==========================================================================
+
+int FLoadTaskGraph::AddTask(const char *name, std::function<void()> func, ETaskThread thread, std::initializer_list<int> deps)
+{
+	auto task = new FTask;
+	task->Name = name;
+	task->Func = std::move(func);
+	task->Thread = thread;
+	for (int dep : deps)
+	{
+		assert(dep >= 0 && dep < (int)Tasks.Size());
+		task->Deps.Push(dep);
+	}
+	return Tasks.Push(task);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FLoadTaskGraph::RunTask(FTask *task)
+{
+	uint64_t wall = I_nsTime();
+	uint64_t cpu = I_ThreadCPUTimeNS();
+	task->Func();
+	task->CPUNS = I_ThreadCPUTimeNS() - cpu;
+	task->WallNS = I_nsTime() - wall;
+}
+
+//==========================================================================
+//
+// Runs all tasks and returns once every one of them has finished. If any
+// task throws, the first exception in insertion order is rethrown here and
+// tasks depending on the failed one are skipped.
+//
+//==========================================================================
+
+void FLoadTaskGraph::Run(bool parallel)
+{
+	Start(parallel);
+	Finish();
+}
+
+void FLoadTaskGraph::Start(bool parallel)
+{
+	assert(!Started);
+	Started = true;
+	if (!parallel)
+	{
+		for (auto task : Tasks)
+		{
+			std::promise<void> done;
+			task->Done = done.get_future().share();
+			RunTask(task);
+			done.set_value();
+		}
+		return;
+	}
+
+	// Queue the worker tasks first. Since the pool is FIFO and dependencies
+	// always precede their dependents, a worker blocking on its dependencies
+	// can never starve one of them.
+	std::vector<std::promise<void>> mainpromises(Tasks.Size());
+	for (unsigned i = 0; i < Tasks.Size(); i++)
+	{
+		auto task = Tasks[i];
+		if (task->Thread == Worker)
+		{
+			TArray<FTask *> deps;
+			for (int dep : task->Deps) deps.Push(Tasks[dep]);
+			task->Done = Pool().push([=](int)
+			{
+				for (auto dep : deps) dep->Done.get();
+				RunTask(task);
+			}).share();
+		}
+		else
+		{
+			task->Done = mainpromises[i].get_future().share();
+		}
+	}
+
+	for (unsigned i = 0; i < Tasks.Size(); i++)
+	{
+		auto task = Tasks[i];
+		if (task->Thread != MainThread) continue;
+		try
+		{
+			for (int dep : task->Deps) Tasks[dep]->Done.get();
+			RunTask(task);
+			mainpromises[i].set_value();
+		}
+		catch (...)
+		{
+			mainpromises[i].set_exception(std::current_exception());
+		}
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FLoadTaskGraph::Finish()
+{
+	if (!Started)
+		return;
+	Started = false;
+
+	// Wait for everything before reporting errors, the tasks may reference
+	// data owned by the caller.
+	for (auto task : Tasks)
+	{
+		task->Done.wait();
+	}
+	for (auto task : Tasks)
+	{
+		task->Done.get();
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FLoadTaskGraph::PrintTimes(const char *title) const
+{
+	Printf("---%s---\n", title);
+	for (unsigned i = 0; i < Tasks.Size(); i++)
+	{
+		auto task = Tasks[i];
+		Printf("Task%3d:%9.4f ms wall,%9.4f ms cpu (%s%s)\n", i, task->WallNS / 1e6, task->CPUNS / 1e6,
+			task->Name, task->Thread == Worker ? ", worker" : "");
+	}
+}
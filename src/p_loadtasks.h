@@ -0,0 +1,63 @@
+#pragma once
+
+//
+//---------------------------------------------------------------------------
+//
+// Dependency-aware task list for the level loader
+//
+// Stages are added in a valid serial order. When run in parallel, stages
+// flagged as worker stages are handed to a thread pool as soon as all of
+// their dependencies have finished, while the remaining stages are run by
+// the calling thread in the order they were added. Anything that prints,
+// reads lumps or touches global state must stay on the calling thread.
+//
+//---------------------------------------------------------------------------
+//
+
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include "tarray.h"
+
+namespace ctpl { class thread_pool; }
+
+class FLoadTaskGraph
+{
+public:
+	enum ETaskThread
+	{
+		MainThread,
+		Worker
+	};
+
+	struct FTask
+	{
+		const char *Name;
+		std::function<void()> Func;
+		TArray<int> Deps;
+		ETaskThread Thread;
+		std::shared_future<void> Done;
+		uint64_t WallNS = 0;
+		uint64_t CPUNS = 0;
+	};
+
+	~FLoadTaskGraph();
+
+	int AddTask(const char *name, std::function<void()> func, ETaskThread thread = MainThread, std::initializer_list<int> deps = {});
+	void Run(bool parallel);
+
+	// Like Run, but Start returns once the main thread tasks are done and
+	// the worker tasks can keep going until Finish is called.
+	void Start(bool parallel);
+	void Finish();
+	void PrintTimes(const char *title) const;
+	void Clear();
+
+	static ctpl::thread_pool &Pool();
+
+private:
+	static void RunTask(FTask *task);
+
+	TArray<FTask *> Tasks;
+	bool Started = false;
+};
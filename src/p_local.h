@@ -277,6 +277,7 @@ void	P_SlideMove (AActor* mo, const DVector2 &pos, int numsteps);
 bool	P_BounceWall (AActor *mo);
 bool	P_BounceActor (AActor *mo, AActor *BlockingMobj, bool ontop);
 int	P_CheckSight (AActor *t1, AActor *t2, int flags=0);
+int	P_CheckSightAny (AActor *const *sources, int count, AActor *target, int flags=0);
 
 enum ESightFlags
 {
@@ -287,6 +288,8 @@ enum ESightFlags
 };
 
 void	P_ResetSightCounters (bool full);
+void	P_InvalidateSightCache ();
+void	P_InvalidateSightCache (sector_t *sec);
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
 int	P_UsePuzzleItem (AActor *actor, int itemType);
@@ -330,11 +330,18 @@ void AActor::UnlinkFromWorld (FLinkContext *ctx)
 
 		while (block != NULL)
 		{
-			if (block->NextActor != NULL)
+			if (level.blockmap.blockthings != NULL)
 			{
-				block->NextActor->PrevActor = block->PrevActor;
+				level.blockmap.UnlinkFlat(block);
+			}
+			else
+			{
+				if (block->NextActor != NULL)
+				{
+					block->NextActor->PrevActor = block->PrevActor;
+				}
+				*(block->PrevActor) = block->NextActor;
 			}
-			*(block->PrevActor) = block->NextActor;
 			FBlockNode *next = block->NextBlock;
 			block->Release ();
 			block = next;
@@ -534,12 +541,19 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 						FBlockNode *node = FBlockNode::Create(this, x, y, this->Sector->PortalGroup);
 
 						// Link in to block
-						if ((node->NextActor = *link) != NULL)
+						if (level.blockmap.blockthings != NULL)
 						{
-							(*link)->PrevActor = &node->NextActor;
+							level.blockmap.LinkFlat(node);
+						}
+						else
+						{
+							if ((node->NextActor = *link) != NULL)
+							{
+								(*link)->PrevActor = &node->NextActor;
+							}
+							node->PrevActor = link;
+							*link = node;
 						}
-						node->PrevActor = link;
-						*link = node;
 
 						// Link in to actor
 						node->PrevBlock = alink;
@@ -601,6 +615,35 @@ void FBlockNode::Release ()
 	FreeBlocks = this;
 }
 
+//===========================================================================
+//
+// FBlockmap :: LinkFlat / UnlinkFlat
+//
+// The flat lists keep the oldest actor first and are walked backwards,
+// which visits the actors in the same order as the linked chains. Removal
+// must therefore preserve the order of the remaining entries.
+//
+//===========================================================================
+
+void FBlockmap::LinkFlat(FBlockNode *node)
+{
+	blockthings[node->BlockIndex].Push(node->Me);
+}
+
+int FBlockmap::UnlinkFlat(FBlockNode *node)
+{
+	auto &list = blockthings[node->BlockIndex];
+	for (int i = list.Size() - 1; i >= 0; i--)
+	{
+		if (list[i] == node->Me)
+		{
+			list.Delete(i);
+			return i;
+		}
+	}
+	return -1;
+}
+
 //
 // BLOCK MAP ITERATORS
 // For each line/thing in the given mapblock,
@@ -910,6 +953,61 @@ void FMultiBlockLinesIterator::Reset()
 	startIteratorForGroup(basegroup);
 }
 
+//===========================================================================
+//
+// FBlockActorIterator
+//
+//===========================================================================
+
+void FBlockActorIterator::Start(int blockindex)
+{
+	node = NULL;
+	list = NULL;
+	last = NULL;
+	index = 0;
+	if (blockindex < 0)
+	{
+		return;
+	}
+	if (level.blockmap.blockthings != NULL)
+	{
+		list = &level.blockmap.blockthings[blockindex];
+		index = list->Size();
+	}
+	else
+	{
+		node = level.blockmap.blocklinks[blockindex];
+	}
+}
+
+AActor *FBlockActorIterator::Next()
+{
+	if (list == NULL)
+	{
+		if (node == NULL) return NULL;
+		AActor *me = node->Me;
+		node = node->NextActor;
+		return me;
+	}
+
+	// The caller may have moved or removed actors in this block since the
+	// last call. Entries can only shift down when something below them is
+	// removed, so look for the last returned actor there. If it is gone,
+	// nothing below the old position has changed.
+	if (last != NULL && (index >= (int)list->Size() || (*list)[index] != last))
+	{
+		int i = MIN<int>(index, list->Size()) - 1;
+		while (i >= 0 && (*list)[i] != last) i--;
+		index = i >= 0 ? i : MIN<int>(index, list->Size());
+	}
+	if (--index < 0)
+	{
+		list = NULL;
+		return NULL;
+	}
+	return last = (*list)[index];
+}
+
 //===========================================================================
 //
 // FBlockThingsIterator :: FBlockThingsIterator
@@ -922,7 +1020,7 @@ FBlockThingsIterator::FBlockThingsIterator()
 	minx = maxx = 0;
 	miny = maxy = 0;
 	ClearHash();
-	block = NULL;
+	block.Start(-1);
 }
 
 FBlockThingsIterator::FBlockThingsIterator(int _minx, int _miny, int _maxx, int _maxy)
@@ -971,12 +1069,12 @@ void FBlockThingsIterator::StartBlock(int x, int y)
 	cury = y;
 	if (level.blockmap.isValidBlock(x, y))
 	{
-		block = level.blockmap.blocklinks[y*level.blockmap.bmapwidth + x];
+		block.Start(y*level.blockmap.bmapwidth + x);
 	}
 	else
 	{
 		// invalid block
-		block = NULL;
+		block.Start(-1);
 	}
 }
 
@@ -1003,16 +1101,14 @@ AActor *FBlockThingsIterator::Next(bool centeronly)
 {
 	for (;;)
 	{
-		while (block != NULL)
+		AActor *me;
+		while ((me = block.Next()) != NULL)
 		{
-			AActor *me = block->Me;
-			FBlockNode *mynode = block;
 			HashEntry *entry;
 			int i;
 
-			block = block->NextActor;
 			// Don't recheck things that were already checked
-			if (mynode->NextBlock == NULL && mynode->PrevBlock == &me->BlockNode)
+			if (me->BlockNode != NULL && me->BlockNode->NextBlock == NULL)
 			{ // This actor doesn't span blocks, so we know it can only ever be checked once.
 				return me;
 			}
@@ -1821,23 +1917,24 @@ static AActor *RoughBlockCheck (AActor *mo, int index, void *param)
 {
 	BlockCheckInfo *info = (BlockCheckInfo *)param;
 
-	FBlockNode *link;
+	FBlockActorIterator it(index);
+	AActor *link;
 
-	for (link = level.blockmap.blocklinks[index]; link != NULL; link = link->NextActor)
+	while ((link = it.Next()) != NULL)
 	{
-		if (link->Me != mo)
+		if (link != mo)
 		{
-			if (info->onlyseekable && !mo->CanSeek(link->Me))
+			if (info->onlyseekable && !mo->CanSeek(link))
 			{
 				continue;
 			}
-			if (info->frontonly && P_PointOnDivlineSide(link->Me->X(), link->Me->Y(), &info->frontline) != 0)
+			if (info->frontonly && P_PointOnDivlineSide(link->X(), link->Y(), &info->frontline) != 0)
 			{
 				continue;
 			}
-			if (mo->IsOkayToAttack (link->Me))
+			if (mo->IsOkayToAttack (link))
 			{
-				return link->Me;
+				return link;
 			}
 		}
 	}
@@ -274,6 +274,33 @@ public:
 };
 
 
+//===========================================================================
+//
+// Walks the actors in a single block, newest first, for either the
+// linked or the flat blockmap storage.
+//
+//===========================================================================
+
+class FBlockActorIterator
+{
+	FBlockNode *node;
+	TArray<AActor *> *list;
+	int index;
+	AActor *last;
+
+public:
+	FBlockActorIterator()
+	{
+		Start(-1);
+	}
+	FBlockActorIterator(int blockindex)
+	{
+		Start(blockindex);
+	}
+	void Start(int blockindex);
+	AActor *Next();
+};
+
 class FBlockThingsIterator
 {
 	int minx, maxx;
@@ -281,7 +308,7 @@ class FBlockThingsIterator
 
 	int curx, cury;
 
-	FBlockNode *block;
+	FBlockActorIterator block;
 
 	int Buckets[32];
 
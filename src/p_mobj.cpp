@@ -4416,7 +4416,11 @@ AActor *AActor::StaticSpawn (PClassActor *type, const DVector3 &pos, replace_t a
 	}
 
 	AActor *actor;
-	
+
+	if (type->bCodePending)
+	{
+		VMFinishDeferred(type);
+	}
 	actor = static_cast<AActor *>(const_cast<PClassActor *>(type)->CreateNew ());
 	actor->SpawnTime = level.totaltime;
 	actor->SpawnOrder = level.spawnindex++;
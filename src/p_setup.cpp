@@ -103,6 +103,7 @@
 #include "i_time.h"
 #include "scripting/vm/vm.h"
 #include "hwrenderer/data/flatvertices.h"
+#include "p_loadtasks.h"
 
 #include "fragglescript/t_fs.h"
 
@@ -130,6 +131,9 @@ CVAR (Bool, genblockmap, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, gennodes, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
 CVAR (Bool, genglnodes, false, CVAR_SERVERINFO);
 CVAR (Bool, showloadtimes, false, 0);
+CVAR (Bool, map_parallelload, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
+// Store the things in each block in a flat array instead of a linked chain. Takes effect on the next level load.
+CVAR (Bool, blockmap_flatlists, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
 
 static void P_Shutdown ();
 
@@ -2499,6 +2503,7 @@ void MapLoader::CreateBlockMap ()
 	CreatePackedBlockmap (BlockMap, BlockLists, bmapwidth, bmapheight);
 	delete[] BlockLists;
 
+	CreatedBlockMapSize = BlockMap.Size();
 	Level->blockmap.blockmaplump = new int[BlockMap.Size()];
 	for (unsigned int ii = 0; ii < BlockMap.Size(); ++ii)
 	{
@@ -2602,7 +2607,7 @@ bool FBlockmap::VerifyBlockMap(int count, unsigned numlines)
 //
 //===========================================================================
 
-void MapLoader::LoadBlockMap (MapData * map)
+bool MapLoader::ReadBlockMap (MapData * map)
 {
 	int count = map->Size(ML_BLOCKMAP);
 
@@ -2612,7 +2617,7 @@ void MapLoader::LoadBlockMap (MapData * map)
 		)
 	{
 		DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
-		CreateBlockMap ();
+		return false;
 	}
 	else
 	{
@@ -2644,10 +2649,25 @@ void MapLoader::LoadBlockMap (MapData * map)
 		if (!Level->blockmap.VerifyBlockMap(count, Level->lines.Size()))
 		{
 			DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
-			CreateBlockMap();
+			delete[] Level->blockmap.blockmaplump;
+			Level->blockmap.blockmaplump = nullptr;
+			return false;
 		}
-
 	}
+	return true;
+}
+
+//===========================================================================
+//
+// Sets up the blockmap's header fields and the empty actor chains.
+// This is split from the lump reading so that a blockmap which needs to
+// be generated can be built off the main thread.
+//
+//===========================================================================
+
+void MapLoader::LinkBlockMap ()
+{
+	int count;
 
 	Level->blockmap.bmaporgx = Level->blockmap.blockmaplump[0];
 	Level->blockmap.bmaporgy = Level->blockmap.blockmaplump[1];
@@ -2658,9 +2678,19 @@ void MapLoader::LoadBlockMap (MapData * map)
 	count = Level->blockmap.bmapwidth*Level->blockmap.bmapheight;
 	Level->blockmap.blocklinks = new FBlockNode *[count];
 	memset (Level->blockmap.blocklinks, 0, count*sizeof(*Level->blockmap.blocklinks));
+	Level->blockmap.blockthings = blockmap_flatlists ? new TArray<AActor *>[count] : nullptr;
 	Level->blockmap.blockmap = Level->blockmap.blockmaplump+4;
 }
 
+void MapLoader::LoadBlockMap (MapData * map)
+{
+	if (!ReadBlockMap(map))
+	{
+		CreateBlockMap();
+	}
+	LinkBlockMap();
+}
+
 //===========================================================================
 //
 // P_GroupLines
@@ -3605,25 +3635,65 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 	// set the head node for gameplay purposes. If the separate gamenodes array is not empty, use that, otherwise use the render nodes.
 	level.headgamenode = level.gamenodes.Size() > 0 ? &level.gamenodes[level.gamenodes.Size() - 1] : level.nodes.Size() ? &level.nodes[level.nodes.Size() - 1] : nullptr;
 
-	times[10].Clock();
-	loader.LoadBlockMap(map);
-	times[10].Unclock();
-
-	times[11].Clock();
-	loader.LoadReject(map, buildmap);
-	times[11].Unclock();
-
-	times[12].Clock();
-	loader.GroupLines(buildmap);
-	times[12].Unclock();
-
-	times[13].Clock();
-	loader.FloodZones();
-	times[13].Unclock();
-
-	loader.SetRenderSector();
-	FixMinisegReferences();
-	FixHoles();
+	// The blockmap only depends on the final vertices and lines, so if it
+	// has to be generated that can run alongside the sector setup.
+	// Lump reading stays on this thread because all lumps share one reader.
+	FLoadTaskGraph setuptasks;
+	bool blockmaplump = false, blockmapbuilt = false;
+	int readblockmap = setuptasks.AddTask("read blockmap", [&]() { blockmaplump = loader.ReadBlockMap(map); });
+	int createblockmap = setuptasks.AddTask("create blockmap", [&]()
+	{
+		times[10].Clock();
+		if (!blockmaplump && !loader.CheckCachedBlockMap(map))
+		{
+			loader.CreateBlockMap();
+			blockmapbuilt = true;
+		}
+		loader.LinkBlockMap();
+		times[10].Unclock();
+	}, FLoadTaskGraph::Worker, { readblockmap });
+	int grouplines = setuptasks.AddTask("group lines", [&]()
+	{
+		times[12].Clock();
+		loader.GroupLines(buildmap);
+		times[12].Unclock();
+	});
+	int rendersectors = setuptasks.AddTask("render sectors", [&]()
+	{
+		loader.SetRenderSector();
+		FixMinisegReferences();
+		FixHoles();
+	}, FLoadTaskGraph::MainThread, { grouplines });
+	// Sections are pure geometry once the subsectors are final. The only thing
+	// they print is a developer message, so keep them here when that is enabled.
+	setuptasks.AddTask("create sections", [&]()
+	{
+		CreateSections(level.sections);
+	}, developer >= DMSG_NOTIFY ? FLoadTaskGraph::MainThread : FLoadTaskGraph::Worker, { rendersectors });
+	setuptasks.AddTask("load reject", [&]()
+	{
+		times[11].Clock();
+		loader.LoadReject(map, buildmap);
+		times[11].Unclock();
+	});
+	setuptasks.AddTask("flood zones", [&]()
+	{
+		times[13].Clock();
+		loader.FloodZones();
+		times[13].Unclock();
+	}, FLoadTaskGraph::MainThread, { grouplines });
+	setuptasks.AddTask("cache blockmap", [&]()
+	{
+		if (blockmapbuilt) loader.CreateCachedBlockMap(map);
+	}, FLoadTaskGraph::MainThread, { createblockmap });
+	setuptasks.Run(map_parallelload);
+
+	// The flat vertex buffer's geometry only depends on the sections, so it
+	// gets built while the things are spawned.
+	FLoadTaskGraph vertextasks;
+	VertexContainers flatvertices;
+	vertextasks.AddTask("build flat vertices", [&]() { flatvertices = BuildVertices(); }, FLoadTaskGraph::Worker);
+	vertextasks.Start(map_parallelload);
 
 	level.bodyqueslot = 0;
 	// phares 8/10/98: Clear body queue so the corpses from previous games are
@@ -3632,8 +3702,6 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 	for(auto & p : level.bodyque)
 		p = nullptr;
 
-	CreateSections(level.sections);
-
 	if (!buildmap)
 	{
 		// [RH] Spawn slope creating things first.
@@ -3693,9 +3761,11 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 	// CreateVBO must be run on the plain 3D floor data.
 	P_ClearDynamic3DFloorData();
 
+	vertextasks.Finish();
+
 	// This must be done BEFORE the PolyObj Spawn!!!
 	InitRenderInfo();			// create hardware independent renderer resources for the level.
-	screen->mVertexData->CreateVBO();
+	screen->mVertexData->CreateVBO(flatvertices);
 
 	for (auto &sec : level.sectors)
 	{
@@ -3852,6 +3922,8 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 			};
 			Printf("Time%3d:%9.4f ms (%s)\n", i, times[i].TimeMS(), timenames[i]);
 		}
+		setuptasks.PrintTimes("Level setup stages");
+		vertextasks.PrintTimes("Background stages");
 	}
 	MapThingsConverted.Clear();
 
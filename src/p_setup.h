@@ -303,6 +303,7 @@ class MapLoader
 	bool LoadNodes(FileReader &lump);
 	bool DoLoadGLNodes(FileReader * lumps);
 	void CreateCachedNodes(MapData *map);
+	unsigned CreatedBlockMapSize = 0;
 
 	void SetTexture(side_t *side, int position, const char *name, FMissingTextureTracker &track);
 	void SetTexture(sector_t *sector, int index, int position, const char *name, FMissingTextureTracker &track, bool truncate);
@@ -322,7 +323,6 @@ class MapLoader
 	void AllocateSideDefs(MapData *map, int count);
 	void ProcessSideTextures(bool checktranmap, side_t *sd, sector_t *sec, intmapsidedef_t *msd, int special, int tag, short *alpha, FMissingTextureTracker &missingtex);
 	void SetMapThingUserData(AActor *actor, unsigned udi);
-	void CreateBlockMap();
 
 	void AddToList(uint8_t *hitlist, FTextureID texid, int bitmask);
 
@@ -338,6 +338,8 @@ public:
 	template<class nodetype, class subsectortype> void LoadNodes(MapData * map);
 	bool LoadGLNodes(MapData * map);
 	bool CheckCachedNodes(MapData *map);
+	bool CheckCachedBlockMap(MapData *map);
+	void CreateCachedBlockMap(MapData *map);
 	bool CheckNodes(MapData * map, bool rebuilt, int buildtime);
 	bool CheckForGLNodes();
 
@@ -352,6 +354,9 @@ public:
 	void LoopSidedefs(bool firstloop);
 	void LoadSideDefs2(MapData *map, FMissingTextureTracker &missingtex);
 	void LoadBlockMap(MapData * map);
+	bool ReadBlockMap(MapData * map);
+	void CreateBlockMap();
+	void LinkBlockMap();
 	void LoadReject(MapData * map, bool junk);
 	void LoadBehavior(MapData * map);
 	void GetPolySpots(MapData * map, TArray<FNodeBuilder::FPolyStart> &spots, TArray<FNodeBuilder::FPolyStart> &anchors);
@@ -52,9 +52,120 @@ This uses specialized forms of the maputils routines for optimized performance
 
 // Performance meters
 static int sightcounts[6];
+static int sightcachecounts[2];	// hits, misses
 static cycle_t SightCycles;
 static cycle_t MaxSightCycles;
 
+// Remembers the outcome of the line of sight traversal. It only depends on
+// where the two ends are, not on which actors they belong to, so entries are
+// keyed on the two subsectors and the flags that change the traversal, and
+// must match the exact positions and heights. Note that callers with
+// different flags do not share entries: A_Chase's melee check passes 0 and
+// its missile check SF_SEEPASTBLOCKEVERYTHING. Hits come from the same
+// question being asked again within a tic, e.g. by several scripts polling
+// CheckSight or CheckIfSeen, or from P_CheckSightAny.
+//
+// Each entry records the sectors whose planes the traversal looked at, so a
+// moving floor or ceiling only invalidates the entries that went through it.
+// Everything is dropped at the start of a tic and when a line special runs
+// or a polyobject moves, since those can change lines anywhere.
+CVAR(Bool, sv_sightcache, false, CVAR_SERVERINFO)
+
+enum
+{
+	SIGHTCACHESIZE = 1024,
+	SIGHTCACHESECTORS = 15,
+	SIGHTCACHE_ALLSECTORS = 0xff,	// the traversal touched too many sectors to list them
+	SIGHTCACHE_KEYFLAGS = SF_SEEPASTSHOOTABLELINES | SF_SEEPASTBLOCKEVERYTHING | SF_IGNOREWATERBOUNDARY,
+};
+
+struct FSightCacheEntry
+{
+	const subsector_t *ss1, *ss2;
+	DVector3 pos1, pos2;
+	double height1, height2;
+	unsigned epoch;
+	unsigned stamp;
+	int flags;
+	bool result;
+	uint8_t numsectors;
+	int sectors[SIGHTCACHESECTORS];
+};
+
+static FSightCacheEntry SightCache[SIGHTCACHESIZE];
+static unsigned SightCacheEpoch = 1;
+static unsigned SightCacheClock;			// advanced by every sector that moves
+static unsigned SightCacheLastSectorMove;
+static TArray<unsigned> SectorSightStamps;	// the clock value of each sector's last move
+
+// Collects the sectors a traversal depends on.
+struct FSightSectorList
+{
+	int numsectors = 0;
+	int sectors[SIGHTCACHESECTORS];
+
+	void Add(const sector_t *sec)
+	{
+		if (numsectors == SIGHTCACHE_ALLSECTORS) return;
+		int index = sec->Index();
+		for (int i = 0; i < numsectors; i++)
+		{
+			if (sectors[i] == index) return;
+		}
+		if (numsectors == SIGHTCACHESECTORS) numsectors = SIGHTCACHE_ALLSECTORS;
+		else sectors[numsectors++] = index;
+	}
+
+	void AddWithFloors(const sector_t *sec)
+	{
+		Add(sec);
+		for (auto rover : sec->e->XFloor.ffloors)
+		{
+			if (rover->model != nullptr) Add(rover->model);
+		}
+	}
+};
+
+void P_InvalidateSightCache()
+{
+	SightCacheEpoch++;
+}
+
+void P_InvalidateSightCache(sector_t *sec)
+{
+	unsigned index = sec->Index();
+	if (index >= SectorSightStamps.Size())
+	{
+		SightCacheEpoch++;
+		return;
+	}
+	SectorSightStamps[index] = SightCacheLastSectorMove = ++SightCacheClock;
+}
+
+static FSightCacheEntry &SightCacheSlot(const subsector_t *ss1, const subsector_t *ss2, int flags)
+{
+	size_t hash = (size_t(ss1) >> 4) * 31 + (size_t(ss2) >> 4) + flags;
+	return SightCache[(hash ^ (hash >> 10)) & (SIGHTCACHESIZE - 1)];
+}
+
+static bool SightCacheMatches(const FSightCacheEntry &e, AActor *t1, AActor *t2, int flags)
+{
+	if (e.epoch != SightCacheEpoch || e.ss1 != t1->subsector || e.ss2 != t2->subsector || e.flags != flags ||
+		e.pos1 != t1->Pos() || e.pos2 != t2->Pos() || e.height1 != t1->Height || e.height2 != t2->Height)
+	{
+		return false;
+	}
+	if (e.numsectors == SIGHTCACHE_ALLSECTORS)
+	{
+		return SightCacheLastSectorMove <= e.stamp;
+	}
+	for (int i = 0; i < e.numsectors; i++)
+	{
+		if (SectorSightStamps[e.sectors[i]] > e.stamp) return false;
+	}
+	return true;
+}
+
 enum
 {
 	SO_TOPFRONT = 1,
@@ -107,6 +218,7 @@ class SightCheck
 	int portalgroup;
 	bool portalfound;
 	unsigned int myseethrough;
+	FSightSectorList *touched;
 
 	void P_SightOpening(SightOpening &open, const line_t *linedef, double x, double y);
 	bool PTR_SightTraverse (intercept_t *in);
@@ -118,7 +230,7 @@ class SightCheck
 public:
 	bool P_SightPathTraverse ();
 
-	void init(AActor * t1, AActor * t2, sector_t *startsector, SightTask *task, int flags)
+	void init(AActor * t1, AActor * t2, sector_t *startsector, SightTask *task, int flags, FSightSectorList *touchedsectors)
 	{
 		sightstart = t1->PosRelative(task->portalgroup);
 		sightend = t2->PosRelative(task->portalgroup);
@@ -137,6 +249,7 @@ public:
 		portalfound = false;
 
 		myseethrough = FF_SEETHROUGH;
+		touched = touchedsectors;
 	}
 };
 
@@ -210,6 +323,11 @@ bool SightCheck::PTR_SightTraverse (intercept_t *in)
 	int  frontflag = -1;
 
 	li = in->d.line;
+	if (touched != nullptr)
+	{
+		touched->AddWithFloors(li->frontsector);
+		if (li->backsector != nullptr) touched->AddWithFloors(li->backsector);
+	}
 
 //
 // crosses a two sided line
@@ -821,36 +939,60 @@ sightcounts[2]++;
 	return traverseres;
 }
 
-/*
-=====================
-=
-= P_CheckSight
-=
-= Returns true if a straight line between t1 and t2 is unobstructed
-= look from eyes of t1 to any part of t2
-=
-= killough 4/20/98: cleaned up, made to use new LOS struct
-=
-=====================
-*/
+//==========================================================================
+//
+// SightTraverse
+//
+// Looks from the eyes of t1 to any part of t2 through the blockmap.
+//
+//==========================================================================
 
-int P_CheckSight (AActor *t1, AActor *t2, int flags)
+static bool SightTraverse(AActor *t1, AActor *t2, int flags, FSightSectorList *touched)
 {
-	SightCycles.Clock();
-
 	bool res;
 
-	assert (t1 != NULL);
-	assert (t2 != NULL);
-	if (t1 == NULL || t2 == NULL)
+	validcount++;
+	portals.Clear();
+
+	sector_t *sec;
+	double lookheight = t1->Z() + t1->Height*0.75;
+	t1->GetPortalTransition(lookheight, &sec);
+
+	double bottomslope = t2->Z() - lookheight;
+	double topslope = bottomslope + t2->Height;
+	SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
+
+
+	SightCheck s;
+	s.init(t1, t2, sec, &task, flags, touched);
+	res = s.P_SightPathTraverse ();
+	if (!res)
 	{
-		return false;
+		double dist = t1->Distance2D(t2);
+		for (unsigned i = 0; i < portals.Size(); i++)
+		{
+			portals[i].Frac += 1 / dist;
+			s.init(t1, t2, NULL, &portals[i], flags, touched);
+			if (s.P_SightPathTraverse())
+			{
+				res = true;
+				break;
+			}
+		}
 	}
+	return res;
+}
 
-	const sector_t *s1 = t1->Sector;
-	const sector_t *s2 = t2->Sector;
-	int pnum = int(s1->Index()) * level.sectors.Size() + int(s2->Index());
+//==========================================================================
+//
+// CheckSight
+//
+// pnum is the index of the sector pair in the reject matrix.
+//
+//==========================================================================
 
+static bool CheckSight (AActor *t1, AActor *t2, int flags, int pnum)
+{
 //
 // check for trivial rejection
 //
@@ -858,8 +1000,7 @@ int P_CheckSight (AActor *t1, AActor *t2, int flags)
 		(level.rejectmatrix[pnum>>3] & (1 << (pnum & 7))))
 	{
 sightcounts[0]++;
-		res = false;			// can't possibly be connected
-		goto done;
+		return false;			// can't possibly be connected
 	}
 
 //
@@ -871,13 +1012,14 @@ sightcounts[0]++;
 	{ // small chance of an attack being made anyway
 		if ((bglobal.m_Thinking ? pr_botchecksight() : pr_checksight()) > 50)
 		{
-			res = false;
-			goto done;
+			return false;
 		}
 	}
 
 	// killough 4/19/98: make fake floors and ceilings block monster view
 
+	const sector_t *s1 = t1->Sector;
+	const sector_t *s2 = t2->Sector;
 	if (!(flags & SF_IGNOREWATERBOUNDARY))
 	{
 		if ((s1->GetHeightSec() &&
@@ -892,56 +1034,127 @@ sightcounts[0]++;
 			  (t2->Z() >= s2->heightsec->ceilingplane.ZatPoint(t2) &&
 			   t1->Top() <= s2->heightsec->ceilingplane.ZatPoint(t1)))))
 		{
-			res = false;
-			goto done;
+			return false;
 		}
 	}
 
 	// An unobstructed LOS is possible.
 	// Now look from eyes of t1 to any part of t2.
 
-	validcount++;
-	portals.Clear();
+	if (!sv_sightcache)
+	{
+		return SightTraverse(t1, t2, flags, nullptr);
+	}
+
+	int keyflags = flags & SIGHTCACHE_KEYFLAGS;
+	FSightCacheEntry &e = SightCacheSlot(t1->subsector, t2->subsector, keyflags);
+	if (SightCacheMatches(e, t1, t2, keyflags))
+	{
+		sightcachecounts[0]++;
+		return e.result;
+	}
+	sightcachecounts[1]++;
+
+	// The start sectors' planes decide which portal group the trace starts in.
+	FSightSectorList touched;
+	touched.AddWithFloors(t1->Sector);
+	touched.AddWithFloors(t2->Sector);
+	bool res = SightTraverse(t1, t2, flags, &touched);
+
+	e.ss1 = t1->subsector;
+	e.ss2 = t2->subsector;
+	e.pos1 = t1->Pos();
+	e.pos2 = t2->Pos();
+	e.height1 = t1->Height;
+	e.height2 = t2->Height;
+	e.epoch = SightCacheEpoch;
+	e.stamp = SightCacheClock;
+	e.flags = keyflags;
+	e.result = res;
+	e.numsectors = (uint8_t)touched.numsectors;
+	if (touched.numsectors != SIGHTCACHE_ALLSECTORS)
+	{
+		memcpy(e.sectors, touched.sectors, touched.numsectors * sizeof(int));
+	}
+	return res;
+}
+
+/*
+=====================
+=
+= P_CheckSight
+=
+= Returns true if a straight line between t1 and t2 is unobstructed
+= look from eyes of t1 to any part of t2
+=
+= killough 4/20/98: cleaned up, made to use new LOS struct
+=
+=====================
+*/
+
+int P_CheckSight (AActor *t1, AActor *t2, int flags)
+{
+	assert (t1 != NULL);
+	assert (t2 != NULL);
+	if (t1 == NULL || t2 == NULL)
 	{
-		sector_t *sec;
-		double lookheight = t1->Z() + t1->Height*0.75;
-		t1->GetPortalTransition(lookheight, &sec);
+		return false;
+	}
 
-		double bottomslope = t2->Z() - lookheight;
-		double topslope = bottomslope + t2->Height;
-		SightTask task = { 0, topslope, bottomslope, -1, sec->PortalGroup };
+	SightCycles.Clock();
+	int pnum = int(t1->Sector->Index()) * level.sectors.Size() + int(t2->Sector->Index());
+	bool res = CheckSight(t1, t2, flags, pnum);
+	SightCycles.Unclock();
+	return res;
+}
+
+//==========================================================================
+//
+// P_CheckSightAny
+//
+// Checks the sources in order and returns the index of the first one that
+// can see the target, or -1 if none can. Null sources are skipped. The
+// target's reject row is only looked up once, and with sv_sightcache
+// sources at the same spot share the traversal.
+//
+//==========================================================================
 
+int P_CheckSightAny (AActor *const *sources, int count, AActor *target, int flags)
+{
+	assert (target != NULL);
+	if (target == NULL)
+	{
+		return -1;
+	}
 
-		SightCheck s;
-		s.init(t1, t2, sec, &task, flags);
-		res = s.P_SightPathTraverse ();
-		if (!res)
+	SightCycles.Clock();
+	const int numsectors = level.sectors.Size();
+	const int targetsector = target->Sector->Index();
+	int found = -1;
+	for (int i = 0; i < count; i++)
+	{
+		if (sources[i] != nullptr && CheckSight(sources[i], target, flags, sources[i]->Sector->Index() * numsectors + targetsector))
 		{
-			double dist = t1->Distance2D(t2);
-			for (unsigned i = 0; i < portals.Size(); i++)
-			{
-				portals[i].Frac += 1 / dist;
-				s.init(t1, t2, NULL, &portals[i], flags);
-				if (s.P_SightPathTraverse())
-				{
-					res = true;
-					break;
-				}
-			}
+			found = i;
+			break;
 		}
 	}
-
-done:
 	SightCycles.Unclock();
-	return res;
+	return found;
 }
 
 ADD_STAT (sight)
 {
 	FString out;
-	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d\n",
+	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d",
 		SightCycles.TimeMS(), MaxSightCycles.TimeMS(),
 		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5]);
+	if (sv_sightcache)
+	{
+		int total = sightcachecounts[0] + sightcachecounts[1];
+		out.AppendFormat (", cache %d/%d hits (%d%%)", sightcachecounts[0], total, total > 0 ? sightcachecounts[0] * 100 / total : 0);
+	}
+	out += '\n';
 	return out;
 }
 
@@ -957,4 +1170,12 @@ void P_ResetSightCounters (bool full)
 	}
 	SightCycles.Reset();
 	memset (sightcounts, 0, sizeof(sightcounts));
+	memset (sightcachecounts, 0, sizeof(sightcachecounts));
+	P_InvalidateSightCache();
+	if (SectorSightStamps.Size() != level.sectors.Size())
+	{
+		SectorSightStamps.Resize(level.sectors.Size());
+		memset(SectorSightStamps.Data(), 0, SectorSightStamps.Size() * sizeof(unsigned));
+		SightCacheClock = SightCacheLastSectorMove = 0;
+	}
 }
@@ -0,0 +1,377 @@
+//
+//---------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//--------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include "p_thinkerprofile.h"
+#include "rapidjson/rapidjson.h"
+#include "rapidjson/writer.h"
+#include "info.h"
+#include "vm.h"
+#include "files.h"
+#include "cmdlib.h"
+#include "i_time.h"
+#include "c_dispatch.h"
+#include "c_cvars.h"
+#include "v_text.h"
+#include "templates.h"
+
+// Recording stops by itself after this many tics so that a forgotten session cannot eat all memory.
+CVAR(Int, profile_maxtics, 35 * 60 * 10, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+FThinkerProfiler ThinkerProfiler;
+
+static const char *const KindNames[] = { "Classes", "States", "Functions", "ACS" };
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FThinkerProfiler::Start()
+{
+	Clear();
+	Recording = true;
+	SessionStartNS = I_nsTime();
+}
+
+void FThinkerProfiler::Stop()
+{
+	if (TicOpen) EndTic();
+	Recording = false;
+}
+
+void FThinkerProfiler::Clear()
+{
+	Recording = TicOpen = false;
+	Slots.Clear();
+	for (auto &map : SlotMap) map.Clear();
+	OpenSamples.Clear();
+	Samples.Clear();
+	Tics.Clear();
+}
+
+//==========================================================================
+//
+// Everything recorded between two EndTic calls is attributed to the tic
+// that ends the span, so work done before the thinkers run (player
+// movement, weapon states) still ends up in the right tic.
+//
+//==========================================================================
+
+void FThinkerProfiler::BeginTic(int tic)
+{
+	CurrentTic = tic;
+	TicStartNS = I_nsTime();
+	TicOpen = true;
+}
+
+void FThinkerProfiler::EndTic()
+{
+	if (!TicOpen) return;
+	TicOpen = false;
+
+	FTic &tic = Tics[Tics.Reserve(1)];
+	tic.Tic = CurrentTic;
+	tic.StartNS = TicStartNS - SessionStartNS;
+	tic.ThinkNS = I_nsTime() - TicStartNS;
+	tic.FirstSample = Samples.Size();
+	tic.NumSamples = OpenSamples.Size();
+
+	for (auto &sample : OpenSamples)
+	{
+		Slots[sample.Slot].TicSample = -1;
+		Samples.Push(sample);
+	}
+	OpenSamples.Clear();
+
+	if (profile_maxtics > 0 && Tics.Size() >= (unsigned)profile_maxtics)
+	{
+		Recording = false;
+		Printf("Thinker profile stopped after %u tics\n", Tics.Size());
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+int FThinkerProfiler::FindSlot(const void *key, ESlotKind kind, bool &created)
+{
+	int *index = SlotMap[kind].CheckKey(key);
+	created = index == nullptr;
+	if (index != nullptr) return *index;
+
+	int slot = Slots.Reserve(1);
+	Slots[slot].Kind = kind;
+	SlotMap[kind][key] = slot;
+	return slot;
+}
+
+void FThinkerProfiler::AddSample(int slot, uint64_t ns)
+{
+	auto &s = Slots[slot];
+	s.Calls++;
+	s.NS += ns;
+	if (s.TicSample < 0)
+	{
+		s.TicSample = OpenSamples.Push({ slot, 0, 0 });
+	}
+	auto &sample = OpenSamples[s.TicSample];
+	sample.Calls++;
+	sample.NS += ns;
+}
+
+void FThinkerProfiler::AddThinker(PClass *cls, FState *state, uint64_t ns)
+{
+	bool created;
+	int slot = FindSlot(cls, KindClass, created);
+	if (created) Slots[slot].Name = cls->TypeName.GetChars();
+	AddSample(slot, ns);
+
+	if (state != nullptr)
+	{
+		slot = FindSlot(state, KindState, created);
+		if (created) Slots[slot].Name = FState::StaticGetStateName(state);
+		AddSample(slot, ns);
+	}
+}
+
+void FThinkerProfiler::AddFunction(VMFunction *func, uint64_t ns)
+{
+	bool created;
+	int slot = FindSlot(func, KindFunction, created);
+	if (created) Slots[slot].Name = func->PrintableName;
+	AddSample(slot, ns);
+}
+
+void FThinkerProfiler::AddScript(int script, FString (*getname)(int), uint64_t ns)
+{
+	bool created;
+	int slot = FindSlot((const void *)(intptr_t)script, KindACS, created);
+	if (created) Slots[slot].Name = getname(script);
+	AddSample(slot, ns);
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FThinkerProfiler::SortedSlots(ESlotKind kind, TArray<int> &out)
+{
+	out.Clear();
+	for (unsigned i = 0; i < Slots.Size(); i++)
+	{
+		if (Slots[i].Kind == kind) out.Push(i);
+	}
+	std::sort(out.begin(), out.end(), [&](int a, int b) { return Slots[a].NS > Slots[b].NS; });
+}
+
+void FThinkerProfiler::PrintReport(unsigned limit)
+{
+	if (Tics.Size() == 0)
+	{
+		Printf("No thinker profile recorded\n");
+		return;
+	}
+
+	uint64_t total = 0;
+	for (auto &tic : Tics) total += tic.ThinkNS;
+	Printf("%u tics, %.3f ms average per tic%s\n", Tics.Size(), total / 1e6 / Tics.Size(), Recording ? " (still recording)" : "");
+
+	TArray<int> sorted;
+	for (int kind = 0; kind < NumKinds; kind++)
+	{
+		SortedSlots(ESlotKind(kind), sorted);
+		if (sorted.Size() == 0) continue;
+
+		Printf(TEXTCOLOR_YELLOW "\nTotal, ms   Per tic, ms  Calls     %s\n", KindNames[kind]);
+		Printf(TEXTCOLOR_YELLOW "----------  -----------  --------  --------------------\n");
+		unsigned count = MIN(limit > 0 ? limit : 20u, sorted.Size());
+		for (unsigned i = 0; i < count; i++)
+		{
+			auto &s = Slots[sorted[i]];
+			Printf("%10.3f  %11.4f  %8u  %s\n", s.NS / 1e6, s.NS / 1e6 / Tics.Size(), s.Calls, s.Name.GetChars());
+		}
+	}
+}
+
+//==========================================================================
+//
+// Chrome trace event format. Every tic is one complete event, and each
+// category gets a counter track holding the per-tic time of its 'limit'
+// most expensive entries. Full session totals go into 'otherData'.
+//
+//==========================================================================
+
+bool FThinkerProfiler::WriteTrace(const char *filename, unsigned limit)
+{
+	if (limit == 0) limit = 16;
+
+	TArray<int> tracked[NumKinds];
+	for (int kind = 0; kind < NumKinds; kind++)
+	{
+		SortedSlots(ESlotKind(kind), tracked[kind]);
+		tracked[kind].Clamp(limit);
+	}
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer, rapidjson::UTF8<> > w(buffer);
+
+	w.StartObject();
+	w.Key("displayTimeUnit");
+	w.String("ms");
+	w.Key("traceEvents");
+	w.StartArray();
+
+	w.StartObject();
+	w.Key("name"); w.String("process_name");
+	w.Key("ph"); w.String("M");
+	w.Key("pid"); w.Int(0);
+	w.Key("args"); w.StartObject(); w.Key("name"); w.String("Playsim"); w.EndObject();
+	w.EndObject();
+
+	TArray<uint64_t> ticns(Slots.Size(), true);
+	for (auto &tic : Tics)
+	{
+		double ts = tic.StartNS / 1e3;
+
+		w.StartObject();
+		w.Key("name"); w.String("Tic");
+		w.Key("cat"); w.String("tic");
+		w.Key("ph"); w.String("X");
+		w.Key("pid"); w.Int(0);
+		w.Key("tid"); w.Int(0);
+		w.Key("ts"); w.Double(ts);
+		w.Key("dur"); w.Double(tic.ThinkNS / 1e3);
+		w.Key("args"); w.StartObject(); w.Key("gametic"); w.Int(tic.Tic); w.EndObject();
+		w.EndObject();
+
+		for (auto &ns : ticns) ns = 0;
+		for (unsigned i = 0; i < tic.NumSamples; i++)
+		{
+			auto &sample = Samples[tic.FirstSample + i];
+			ticns[sample.Slot] = sample.NS;
+		}
+
+		for (int kind = 0; kind < NumKinds; kind++)
+		{
+			if (tracked[kind].Size() == 0) continue;
+
+			w.StartObject();
+			w.Key("name"); w.String(KindNames[kind]);
+			w.Key("ph"); w.String("C");
+			w.Key("pid"); w.Int(0);
+			w.Key("ts"); w.Double(ts);
+			w.Key("args");
+			w.StartObject();
+			for (int slot : tracked[kind])
+			{
+				w.Key(Slots[slot].Name.GetChars());
+				w.Double(ticns[slot] / 1e6);
+			}
+			w.EndObject();
+			w.EndObject();
+		}
+	}
+	w.EndArray();
+
+	w.Key("otherData");
+	w.StartObject();
+	w.Key("tics"); w.Uint(Tics.Size());
+	for (int kind = 0; kind < NumKinds; kind++)
+	{
+		TArray<int> sorted;
+		SortedSlots(ESlotKind(kind), sorted);
+
+		w.Key(KindNames[kind]);
+		w.StartArray();
+		for (int slot : sorted)
+		{
+			w.StartObject();
+			w.Key("name"); w.String(Slots[slot].Name.GetChars());
+			w.Key("calls"); w.Uint(Slots[slot].Calls);
+			w.Key("ms"); w.Double(Slots[slot].NS / 1e6);
+			w.EndObject();
+		}
+		w.EndArray();
+	}
+	w.EndObject();
+	w.EndObject();
+
+	FileWriter *fw = FileWriter::Open(filename);
+	if (fw == nullptr) return false;
+	bool ok = fw->Write(buffer.GetString(), buffer.GetSize()) == buffer.GetSize();
+	delete fw;
+	return ok;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+CCMD(thinkerprofile)
+{
+	const char *cmd = argv.argc() > 1 ? argv[1] : "";
+
+	if (!stricmp(cmd, "start"))
+	{
+		ThinkerProfiler.Start();
+		Printf("Thinker profile started\n");
+	}
+	else if (!stricmp(cmd, "stop"))
+	{
+		ThinkerProfiler.Stop();
+		Printf("Thinker profile stopped\n");
+	}
+	else if (!stricmp(cmd, "clear"))
+	{
+		ThinkerProfiler.Clear();
+	}
+	else if (!stricmp(cmd, "report"))
+	{
+		ThinkerProfiler.PrintReport(argv.argc() > 2 ? atoi(argv[2]) : 0);
+	}
+	else if (!stricmp(cmd, "dump") && argv.argc() > 2)
+	{
+		FString filename = argv[2];
+		DefaultExtension(filename, ".json");
+		if (ThinkerProfiler.WriteTrace(filename, argv.argc() > 3 ? atoi(argv[3]) : 0))
+		{
+			Printf("Thinker profile written to %s\n", filename.GetChars());
+		}
+		else
+		{
+			Printf("Could not write %s\n", filename.GetChars());
+		}
+	}
+	else
+	{
+		Printf(
+			"Usage: thinkerprofile start|stop|clear\n"
+			"       thinkerprofile report [limit]\n"
+			"       thinkerprofile dump <file> [tracks per category]\n");
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+//
+//---------------------------------------------------------------------------
+//
+// Session thinker profiler
+//
+// Unlike 'profilethinkers', which prints a single tic, this keeps recording
+// until it is stopped. Time is attributed per thinker class, per state an
+// actor was in when it started its tick, per state action function and per
+// ACS script. Every tic's samples are kept so that the whole session can be
+// written out as a Chrome trace (chrome://tracing, Perfetto) or summarized
+// on the console.
+//
+//---------------------------------------------------------------------------
+//
+
+#include "tarray.h"
+#include "zstring.h"
+
+class PClass;
+struct FState;
+class VMFunction;
+
+class FThinkerProfiler
+{
+public:
+	enum ESlotKind
+	{
+		KindClass,
+		KindState,
+		KindFunction,
+		KindACS,
+		NumKinds
+	};
+
+	bool IsRecording() const { return Recording; }
+
+	void Start();
+	void Stop();
+	void Clear();
+
+	void BeginTic(int tic);
+	void EndTic();
+
+	void AddThinker(PClass *cls, FState *state, uint64_t ns);
+	void AddFunction(VMFunction *func, uint64_t ns);
+	void AddScript(int script, FString (*getname)(int), uint64_t ns);
+
+	void PrintReport(unsigned limit);
+	bool WriteTrace(const char *filename, unsigned limit);
+
+private:
+	struct FSlot
+	{
+		FString Name;
+		ESlotKind Kind;
+		unsigned Calls = 0;
+		uint64_t NS = 0;
+		int TicSample = -1;		// index into the open tic's samples, -1 if not touched yet
+	};
+
+	struct FSample
+	{
+		int Slot;
+		unsigned Calls;
+		uint64_t NS;
+	};
+
+	struct FTic
+	{
+		int Tic;
+		uint64_t StartNS;		// relative to the start of the recording
+		uint64_t ThinkNS;
+		unsigned FirstSample;
+		unsigned NumSamples;
+	};
+
+	int FindSlot(const void *key, ESlotKind kind, bool &created);
+	void AddSample(int slot, uint64_t ns);
+	void SortedSlots(ESlotKind kind, TArray<int> &out);
+
+	bool Recording = false;
+	bool TicOpen = false;
+	uint64_t SessionStartNS = 0;
+	uint64_t TicStartNS = 0;
+	int CurrentTic = 0;
+
+	TArray<FSlot> Slots;
+	TMap<const void *, int> SlotMap[NumKinds];
+	TArray<FSample> OpenSamples;
+	TArray<FSample> Samples;
+	TArray<FTic> Tics;
+};
+
+extern FThinkerProfiler ThinkerProfiler;
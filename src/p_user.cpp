@@ -131,6 +131,7 @@ static int PredictionLerptics;
 static player_t PredictionPlayerBackup;
 static uint8_t PredictionActorBackup[sizeof(APlayerPawn)];
 static TArray<AActor *> PredictionSectorListBackup;
+static TArray<int> PredictionBlockPositions;
 
 static TArray<sector_t *> PredictionTouchingSectorsBackup;
 static TArray<msecnode_t *> PredictionTouchingSectors_sprev_Backup;
@@ -1839,13 +1840,21 @@ void P_PredictPlayer (player_t *player)
 	// without releasing them. (They will be used again in P_UnpredictPlayer).
 	FBlockNode *block = act->BlockNode;
 
+	PredictionBlockPositions.Clear();
 	while (block != NULL)
 	{
-		if (block->NextActor != NULL)
+		if (level.blockmap.blockthings != NULL)
 		{
-			block->NextActor->PrevActor = block->PrevActor;
+			PredictionBlockPositions.Push(level.blockmap.UnlinkFlat(block));
+		}
+		else
+		{
+			if (block->NextActor != NULL)
+			{
+				block->NextActor->PrevActor = block->PrevActor;
+			}
+			*(block->PrevActor) = block->NextActor;
 		}
-		*(block->PrevActor) = block->NextActor;
 		block = block->NextBlock;
 	}
 	act->BlockNode = NULL;
@@ -1975,6 +1984,19 @@ void P_UnPredictPlayer ()
 		// Now fix the pointers in the blocknode chain
 		FBlockNode *block = act->BlockNode;
 
+		if (level.blockmap.blockthings != NULL)
+		{
+			// Reinsert in reverse order of removal so that every stored position is valid again.
+			TArray<FBlockNode *> nodes;
+			for (; block != NULL; block = block->NextBlock) nodes.Push(block);
+			for (int j = (int)nodes.Size() - 1; j >= 0; j--)
+			{
+				auto &list = level.blockmap.blockthings[nodes[j]->BlockIndex];
+				int pos = j < (int)PredictionBlockPositions.Size() ? PredictionBlockPositions[j] : -1;
+				if (pos >= 0 && pos <= (int)list.Size()) list.Insert(pos, act);
+				else list.Push(act);
+			}
+		}
 		while (block != NULL)
 		{
 			*(block->PrevActor) = block;
@@ -935,6 +935,7 @@ void FPolyObj::CalcCenter()
 bool FPolyObj::MovePolyobj (const DVector2 &pos, bool force)
 {
 	FBoundingBox oldbounds = Bounds;
+	P_InvalidateSightCache();
 	UnLinkPolyobj ();
 	DoMovePolyobj (pos);
 
@@ -1014,6 +1015,7 @@ bool FPolyObj::RotatePolyobj (DAngle angle, bool fromsave)
 	DAngle an;
 	bool blocked;
 	FBoundingBox oldbounds = Bounds;
+	P_InvalidateSightCache();
 
 	an = Angle + angle;
 
@@ -1102,7 +1104,6 @@ void FPolyObj::UnLinkPolyobj ()
 bool FPolyObj::CheckMobjBlocking (side_t *sd)
 {
 	static TArray<AActor *> checker;
-	FBlockNode *block;
 	AActor *mobj;
 	int i, j, k;
 	int left, right, top, bottom;
@@ -1135,9 +1136,9 @@ bool FPolyObj::CheckMobjBlocking (side_t *sd)
 	{
 		for (i = left; i <= right; i++)
 		{
-			for (block = level.blockmap.blocklinks[j+i]; block != NULL; block = block->NextActor)
+			FBlockActorIterator it(j+i);
+			while ((mobj = it.Next()) != NULL)
 			{
-				mobj = block->Me;
 				for (k = (int)checker.Size()-1; k >= 0; --k)
 				{
 					if (checker[k] == mobj)
@@ -126,14 +126,13 @@ void PolyTriangleThreadData::ClearStencil(uint8_t value)
 	int height = buffer->Height();
 	uint8_t *data = buffer->Values();
 
-	int skip = skipped_by_thread(0);
-	int count = count_for_thread(0, height);
-
-	data += skip * width;
-	for (int i = 0; i < count; i++)
+	height = MIN(height, numa_end_y);
+	int y = skipped_by_thread(0);
+	while (y < height)
 	{
-		memset(data, value, width);
-		data += num_cores * width;
+		int end = bin_end_for_thread(y);
+		memset(data + y * width, value, (MIN(end, height) - y) * width);
+		y = end + skipped_by_thread(end);
 	}
 }
 
@@ -626,7 +625,7 @@ int PolyTriangleThreadData::ClipEdge(const ShadedTriVertex *verts, ShadedTriVert
 PolyTriangleThreadData *PolyTriangleThreadData::Get(DrawerThread *thread)
 {
 	if (!thread->poly)
-		thread->poly = std::make_shared<PolyTriangleThreadData>(thread->core, thread->num_cores, thread->numa_node, thread->num_numa_nodes, thread->numa_start_y, thread->numa_end_y);
+		thread->poly = std::make_shared<PolyTriangleThreadData>(thread->core, thread->num_cores, thread->numa_node, thread->num_numa_nodes, thread->numa_start_y, thread->numa_end_y, thread->bin_height);
 	return thread->poly.get();
 }
 
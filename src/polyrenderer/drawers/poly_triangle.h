@@ -50,7 +50,7 @@ public:
 class PolyTriangleThreadData
 {
 public:
-	PolyTriangleThreadData(int32_t core, int32_t num_cores, int32_t numa_node, int32_t num_numa_nodes, int numa_start_y, int numa_end_y) : core(core), num_cores(num_cores), numa_node(numa_node), num_numa_nodes(num_numa_nodes), numa_start_y(numa_start_y), numa_end_y(numa_end_y) { }
+	PolyTriangleThreadData(int32_t core, int32_t num_cores, int32_t numa_node, int32_t num_numa_nodes, int numa_start_y, int numa_end_y, int bin_height) : core(core), num_cores(num_cores), numa_node(numa_node), num_numa_nodes(num_numa_nodes), numa_start_y(numa_start_y), numa_end_y(numa_end_y), bin_height(bin_height) { }
 
 	void ClearStencil(uint8_t value);
 	void SetViewport(int x, int y, int width, int height, uint8_t *dest, int dest_width, int dest_height, int dest_pitch, bool dest_bgra);
@@ -71,23 +71,27 @@ public:
 	int numa_start_y;
 	int numa_end_y;
 
+	// Each thread owns whole rows of screen tiles this high (see DrawerThread::bin_height)
+	int bin_height = 1;
+
 	bool line_skipped_by_thread(int line)
 	{
-		return line < numa_start_y || line >= numa_end_y || line % num_cores != core;
+		return line < numa_start_y || line >= numa_end_y || (line / bin_height) % num_cores != core;
 	}
 
 	int skipped_by_thread(int first_line)
 	{
 		int clip_first_line = MAX(first_line, numa_start_y);
-		int core_skip = (num_cores - (clip_first_line - core) % num_cores) % num_cores;
-		return clip_first_line + core_skip - first_line;
+		int bin = clip_first_line / bin_height;
+		int core_skip = (num_cores - (bin - core) % num_cores) % num_cores;
+		if (core_skip != 0)
+			clip_first_line = (bin + core_skip) * bin_height;
+		return clip_first_line - first_line;
 	}
 
-	int count_for_thread(int first_line, int count)
+	int bin_end_for_thread(int line)
 	{
-		count = MIN(count, numa_end_y - first_line);
-		int c = (count - skipped_by_thread(first_line) + num_cores - 1) / num_cores;
-		return MAX(c, 0);
+		return MIN((line / bin_height + 1) * bin_height, numa_end_y);
 	}
 
 	// Varyings
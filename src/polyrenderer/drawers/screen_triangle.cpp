@@ -76,69 +76,77 @@ void ScreenTriangle::Draw(const TriDrawTriangleArgs *args, PolyTriangleThreadDat
 	if (topY >= bottomY)
 		return;
 
+	// Skip ahead to the first tile row owned by this thread. Small triangles usually
+	// miss all of them, and are rejected here before any edge setup is done.
 	topY += thread->skipped_by_thread(topY);
-	int num_cores = thread->num_cores;
+	if (topY >= bottomY)
+		return;
 
 	// Find start/end X positions for each line covered by the triangle:
 
 	int16_t edges[MAXHEIGHT * 2];
 
-	int y = topY;
-
 	float longDX = sortedVertices[2]->x - sortedVertices[0]->x;
 	float longDY = sortedVertices[2]->y - sortedVertices[0]->y;
 	float longStep = longDX / longDY;
-	float longPos = sortedVertices[0]->x + longStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
-	longStep *= num_cores;
 
-	if (y < midY)
+	float topDX = sortedVertices[1]->x - sortedVertices[0]->x;
+	float topDY = sortedVertices[1]->y - sortedVertices[0]->y;
+	float topStep = topDX / topDY;
+
+	float bottomDX = sortedVertices[2]->x - sortedVertices[1]->x;
+	float bottomDY = sortedVertices[2]->y - sortedVertices[1]->y;
+	float bottomStep = bottomDX / bottomDY;
+
+	int y = topY;
+	while (y < bottomY)
 	{
-		float shortDX = sortedVertices[1]->x - sortedVertices[0]->x;
-		float shortDY = sortedVertices[1]->y - sortedVertices[0]->y;
-		float shortStep = shortDX / shortDY;
-		float shortPos = sortedVertices[0]->x + shortStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
-		shortStep *= num_cores;
+		int binEnd = MIN(thread->bin_end_for_thread(y), bottomY);
+
+		float longPos = sortedVertices[0]->x + longStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
 
-		while (y < midY)
+		if (y < midY)
 		{
-			int x0 = (int)shortPos;
-			int x1 = (int)longPos;
-			if (x1 < x0) std::swap(x0, x1);
-			x0 = clamp(x0, clipleft, clipright);
-			x1 = clamp(x1, clipleft, clipright);
-
-			edges[y << 1] = x0;
-			edges[(y << 1) + 1] = x1;
-
-			shortPos += shortStep;
-			longPos += longStep;
-			y += num_cores;
-		}
-	}
+			float shortPos = sortedVertices[0]->x + topStep * (y + 0.5f - sortedVertices[0]->y) + 0.5f;
+			int shortEnd = MIN(midY, binEnd);
+			while (y < shortEnd)
+			{
+				int x0 = (int)shortPos;
+				int x1 = (int)longPos;
+				if (x1 < x0) std::swap(x0, x1);
+				x0 = clamp(x0, clipleft, clipright);
+				x1 = clamp(x1, clipleft, clipright);
 
-	if (y < bottomY)
-	{
-		float shortDX = sortedVertices[2]->x - sortedVertices[1]->x;
-		float shortDY = sortedVertices[2]->y - sortedVertices[1]->y;
-		float shortStep = shortDX / shortDY;
-		float shortPos = sortedVertices[1]->x + shortStep * (y + 0.5f - sortedVertices[1]->y) + 0.5f;
-		shortStep *= num_cores;
+				edges[y << 1] = x0;
+				edges[(y << 1) + 1] = x1;
+
+				shortPos += topStep;
+				longPos += longStep;
+				y++;
+			}
+		}
 
-		while (y < bottomY)
+		if (y < binEnd)
 		{
-			int x0 = (int)shortPos;
-			int x1 = (int)longPos;
-			if (x1 < x0) std::swap(x0, x1);
-			x0 = clamp(x0, clipleft, clipright);
-			x1 = clamp(x1, clipleft, clipright);
-
-			edges[y << 1] = x0;
-			edges[(y << 1) + 1] = x1;
-
-			shortPos += shortStep;
-			longPos += longStep;
-			y += num_cores;
+			float shortPos = sortedVertices[1]->x + bottomStep * (y + 0.5f - sortedVertices[1]->y) + 0.5f;
+			while (y < binEnd)
+			{
+				int x0 = (int)shortPos;
+				int x1 = (int)longPos;
+				if (x1 < x0) std::swap(x0, x1);
+				x0 = clamp(x0, clipleft, clipright);
+				x1 = clamp(x1, clipleft, clipright);
+
+				edges[y << 1] = x0;
+				edges[(y << 1) + 1] = x1;
+
+				shortPos += bottomStep;
+				longPos += longStep;
+				y++;
+			}
 		}
+
+		y += thread->skipped_by_thread(y);
 	}
 
 	int opt = 0;
@@ -200,8 +208,9 @@ void DrawTriangle(const TriDrawTriangleArgs *args, PolyTriangleThreadData *threa
 		weaponWOffset = thread->weaponScene ? 1.0f : 0.0f;
 	}
 
-	int num_cores = thread->num_cores;
-	for (int y = topY; y < bottomY; y += num_cores)
+	int y = topY;
+	int binEnd = MIN(thread->bin_end_for_thread(y), bottomY);
+	while (y < bottomY)
 	{
 		int x = edges[y << 1];
 		int xend = edges[(y << 1) + 1];
@@ -455,6 +464,13 @@ void DrawTriangle(const TriDrawTriangleArgs *args, PolyTriangleThreadData *threa
 			}
 		}
 #endif
+
+		y++;
+		if (y == binEnd)
+		{
+			y += thread->skipped_by_thread(y);
+			binEnd = MIN(thread->bin_end_for_thread(y), bottomY);
+		}
 	}
 }
 
@@ -1635,12 +1651,21 @@ void DrawRect8(const void *destOrg, int destWidth, int destHeight, int destPitch
 
 	uint32_t posV = startV;
 	y1 = MIN(y1, thread->numa_end_y);
-	int num_cores = thread->num_cores;
 	int skip = thread->skipped_by_thread(y0);
 	posV += skip * stepV;
-	stepV *= num_cores;
-	for (int y = y0 + skip; y < y1; y += num_cores, posV += stepV)
+	int binEnd = thread->bin_end_for_thread(y0 + skip);
+	for (int y = y0 + skip; y < y1; y++, posV += stepV)
 	{
+		if (y == binEnd)
+		{
+			skip = thread->skipped_by_thread(y);
+			y += skip;
+			posV += skip * stepV;
+			if (y >= y1)
+				break;
+			binEnd = thread->bin_end_for_thread(y);
+		}
+
 		uint8_t *destLine = ((uint8_t*)destOrg) + y * destPitch;
 
 		uint32_t posU = startU;
@@ -1886,12 +1911,21 @@ void DrawRectOpt32(const void *destOrg, int destWidth, int destHeight, int destP
 
 	uint32_t posV = startV;
 	y1 = MIN(y1, thread->numa_end_y);
-	int num_cores = thread->num_cores;
 	int skip = thread->skipped_by_thread(y0);
 	posV += skip * stepV;
-	stepV *= num_cores;
-	for (int y = y0 + skip; y < y1; y += num_cores, posV += stepV)
+	int binEnd = thread->bin_end_for_thread(y0 + skip);
+	for (int y = y0 + skip; y < y1; y++, posV += stepV)
 	{
+		if (y == binEnd)
+		{
+			skip = thread->skipped_by_thread(y);
+			y += skip;
+			posV += skip * stepV;
+			if (y >= y1)
+				break;
+			binEnd = thread->bin_end_for_thread(y);
+		}
+
 		uint32_t *destLine = ((uint32_t*)destOrg) + y * destPitch;
 
 		uint32_t posU = startU;
@@ -71,7 +71,7 @@ void PolyRenderer::RenderView(player_t *player, DCanvas *target, void *videobuff
 
 	Threads.MainThread()->FlushDrawQueue();
 
-	auto copyqueue = std::make_shared<DrawerCommandQueue>(Threads.MainThread()->FrameMemory.get());
+	auto copyqueue = std::make_shared<DrawerCommandQueue>(Threads.MainThread()->FrameMemory.get(), true);
 	copyqueue->Push<MemcpyCommand>(videobuffer, target->GetPixels(), target->GetWidth(), target->GetHeight(), target->GetPitch(), target->IsBgra() ? 4 : 1);
 	DrawerThreads::Execute(copyqueue);
 
@@ -49,7 +49,7 @@ EXTERN_CVAR(Int, r_scene_multithreaded);
 PolyRenderThread::PolyRenderThread(int threadIndex) : MainThread(threadIndex == 0), ThreadIndex(threadIndex)
 {
 	FrameMemory.reset(new RenderMemory());
-	DrawQueue = std::make_shared<DrawerCommandQueue>(FrameMemory.get());
+	DrawQueue = std::make_shared<DrawerCommandQueue>(FrameMemory.get(), true);
 }
 
 PolyRenderThread::~PolyRenderThread()
@@ -70,7 +70,7 @@ void PolyRenderThread::FlushDrawQueue()
 	}
 	else
 	{
-		DrawQueue = std::make_shared<DrawerCommandQueue>(FrameMemory.get());
+		DrawQueue = std::make_shared<DrawerCommandQueue>(FrameMemory.get(), true);
 	}
 }
 
@@ -60,6 +60,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <mutex>
 #include "doomtype.h"
 #include "i_system.h"
 #include "sc_man.h"
@@ -1145,8 +1146,9 @@ void FScanner::CheckOpen()
 //==========================================================================
 int FScriptPosition::ErrorCounter;
 int FScriptPosition::WarnCounter;
-bool FScriptPosition::StrictErrors;	// makes all OPTERROR messages real errors.
+thread_local bool FScriptPosition::StrictErrors;	// makes all OPTERROR messages real errors.
 bool FScriptPosition::errorout;		// call I_Error instead of printing the error itself.
+thread_local TArray<FScriptMessage> *FScriptPosition::MessageBuffer;	// for code running off the main thread, which must not print.
 
 FScriptPosition::FScriptPosition(const FScriptPosition &other)
 {
@@ -1180,6 +1182,7 @@ FScriptPosition &FScriptPosition::operator=(const FScriptPosition &other)
 //==========================================================================
 
 CVAR(Bool, strictdecorate, false, CVAR_GLOBALCONFIG|CVAR_ARCHIVE)
+static std::mutex MessageMutex;
 
 void FScriptPosition::Message (int severity, const char *message, ...) const
 {
@@ -1211,6 +1214,8 @@ void FScriptPosition::Message (int severity, const char *message, ...) const
 	const char *color;
 	int level = PRINT_HIGH;
 
+	// Function bodies may be emitted on several threads at once.
+	std::lock_guard<std::mutex> lock(MessageMutex);
 	switch (severity)
 	{
 	default:
@@ -1248,8 +1253,32 @@ void FScriptPosition::Message (int severity, const char *message, ...) const
 			FileName.GetChars(), ScriptLine, composed.GetChars());
 		return;
 	}
-	Printf (level, "%sScript %s, \"%s\" line %d:\n%s%s\n",
-		color, type, FileName.GetChars(), ScriptLine, color, composed.GetChars());
+	FString text;
+	text.Format("%sScript %s, \"%s\" line %d:\n%s%s\n", color, type, FileName.GetChars(), ScriptLine, color, composed.GetChars());
+	if (MessageBuffer != nullptr)
+	{
+		MessageBuffer->Push({ level, text });
+	}
+	else
+	{
+		Printf(level, "%s", text.GetChars());
+	}
+}
+
+//==========================================================================
+//
+// FScriptPosition :: PrintMessages
+//
+// Prints the messages that were collected in a MessageBuffer.
+//
+//==========================================================================
+
+void FScriptPosition::PrintMessages(const TArray<FScriptMessage> &messages)
+{
+	for (auto &msg : messages)
+	{
+		Printf(msg.PrintLevel, "%s", msg.Text.GetChars());
+	}
 }
 
 
@@ -74,6 +74,7 @@ public:
 	int MatchString(const char * const *strings, size_t stride = sizeof(char*));
 	int MustMatchString(const char * const *strings, size_t stride = sizeof(char*));
 	int GetMessageLine();
+	const FString &GetScriptBuffer() const { return ScriptBuffer; }
 
 	void ScriptError(const char *message, ...) GCCPRINTF(2,3);
 	void ScriptMessage(const char *message, ...) GCCPRINTF(2,3);
@@ -156,12 +157,19 @@ enum
 //
 //==========================================================================
 
+struct FScriptMessage
+{
+	int PrintLevel;
+	FString Text;
+};
+
 struct FScriptPosition
 {
 	static int WarnCounter;
 	static int ErrorCounter;
-	static bool StrictErrors;
+	static thread_local bool StrictErrors;	// per thread, since function bodies may be emitted on several threads at once.
 	static bool errorout;
+	static thread_local TArray<FScriptMessage> *MessageBuffer;	// if set, messages are collected here instead of being printed.
 	FString FileName;
 	int ScriptLine;
 
@@ -174,6 +182,7 @@ struct FScriptPosition
 	FScriptPosition(FScanner &sc);
 	FScriptPosition &operator=(const FScriptPosition &other);
 	void Message(int severity, const char *message,...) const GCCPRINTF(3,4);
+	static void PrintMessages(const TArray<FScriptMessage> &messages);
 	static void ResetErrorCounter()
 	{
 		WarnCounter = 0;
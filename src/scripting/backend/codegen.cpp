@@ -52,6 +52,29 @@ extern FRandom pr_exrandom;
 FMemArena FxAlloc(65536);
 int utf8_decode(const char *src, int *size);
 
+// Fields made up by the code generator are not in any symbol table, so nothing
+// keeps them alive for the garbage collector. The code of actor classes can be
+// generated long after it was resolved, so these stay fixed until all code is done.
+static TArray<PField *> CodeFields;
+
+static PField *CreateCodeField(FName name, PType *type, uint32_t flags, size_t offset)
+{
+	auto field = Create<PField>(name, type, flags, offset);
+	field->ObjectFlags |= OF_Fixed;
+	CodeFields.Push(field);
+	return field;
+}
+
+void ReleaseCodeFields()
+{
+	for (auto field : CodeFields)
+	{
+		field->ObjectFlags &= ~OF_Fixed;
+	}
+	CodeFields.Clear();
+	CodeFields.ShrinkToFit();
+}
+
 struct FLOP
 {
 	ENamedName Name;
@@ -562,7 +585,7 @@ ExpEmit FxConstant::Emit(VMFunctionBuilder *build)
 	}
 	else if (regtype == REGT_STRING)
 	{
-		out.RegNum = build->GetConstantString(value.GetString());
+		out.RegNum = build->GetConstantString(value.GetStringCopy());
 	}
 	else
 	{
@@ -4459,7 +4482,7 @@ ExpEmit FxBinaryLogical::Emit(VMFunctionBuilder *build)
 	build->Emit(OP_JMP, 1);
 	build->BackpatchListToHere(no);
 	auto ctarget = build->Emit(OP_LI, to.RegNum, (Operator == TK_AndAnd) ? 0 : 1);
-	list.DeleteAndClear();
+	build->DeleteLater(list);
 	list.ShrinkToFit();
 	return to;
 }
@@ -5670,7 +5693,7 @@ ExpEmit FxRandomPick::Emit(VMFunctionBuilder *build)
 	// The result register needs to be in-use when we return.
 	// It should have been freed earlier, so restore its in-use flag.
 	resultreg.Reuse(build);
-	choices.DeleteAndClear();
+	build->DeleteLater(choices);
 	choices.ShrinkToFit();
 	return resultreg;
 }
@@ -6803,7 +6826,7 @@ ExpEmit FxCVar::Emit(VMFunctionBuilder *build)
 //==========================================================================
 
 FxStackVariable::FxStackVariable(PType *type, int offset, const FScriptPosition &pos)
-	: FxMemberBase(EFX_StackVariable, Create<PField>(NAME_None, type, 0, offset), pos)
+	: FxMemberBase(EFX_StackVariable, CreateCodeField(NAME_None, type, 0, offset), pos)
 {
 }
 
@@ -7028,9 +7051,8 @@ FxExpression *FxStructMember::Resolve(FCompileContext &ctx)
 		if (classx->ExprType == EFX_ClassMember || classx->ExprType == EFX_StructMember || classx->ExprType == EFX_GlobalVariable || classx->ExprType == EFX_StackVariable)
 		{
 			auto parentfield = static_cast<FxMemberBase *>(classx)->membervar;
-			// PFields are garbage collected so this will be automatically taken care of later.
 			// [ZZ] call ChangeSideInFlags to ensure that we don't get ui+play
-			auto newfield = Create<PField>(NAME_None, membervar->Type, FScopeBarrier::ChangeSideInFlags(membervar->Flags | parentfield->Flags, BarrierSide), membervar->Offset + parentfield->Offset);
+			auto newfield = CreateCodeField(NAME_None, membervar->Type, FScopeBarrier::ChangeSideInFlags(membervar->Flags | parentfield->Flags, BarrierSide), membervar->Offset + parentfield->Offset);
 			newfield->BitValue = membervar->BitValue;
 			static_cast<FxMemberBase *>(classx)->membervar = newfield;
 			classx->isresolved = false;	// re-resolve the parent so it can also check if it can be optimized away.
@@ -7258,6 +7280,9 @@ FxExpression *FxArrayElement::Resolve(FCompileContext &ctx)
 		{
 			auto parentfield = static_cast<FxMemberBase *>(Array)->membervar;
 			SizeAddr = parentfield->Offset + sizeof(void*);
+			// Create the field for the size here because the code may be emitted on a worker thread.
+			bool ismeta = Array->ExprType == EFX_ClassMember && parentfield->Flags & VARF_Meta;
+			SizeField = CreateCodeField(NAME_None, TypeUInt32, ismeta? VARF_Meta : 0, SizeAddr);
 		}
 		else
 		{
@@ -7282,7 +7307,7 @@ FxExpression *FxArrayElement::Resolve(FCompileContext &ctx)
 		{
 			auto parentfield = static_cast<FxMemberBase *>(Array)->membervar;
 			// PFields are garbage collected so this will be automatically taken care of later.
-			auto newfield = Create<PField>(NAME_None, elementtype, parentfield->Flags, indexval * arraytype->ElementSize + parentfield->Offset);
+			auto newfield = CreateCodeField(NAME_None, elementtype, parentfield->Flags, indexval * arraytype->ElementSize + parentfield->Offset);
 			static_cast<FxMemberBase *>(Array)->membervar = newfield;
 			Array->isresolved = false;	// re-resolve the parent so it can also check if it can be optimized away.
 			auto x = Array->Resolve(ctx);
@@ -7334,14 +7359,11 @@ ExpEmit FxArrayElement::Emit(VMFunctionBuilder *build)
 
 	if (SizeAddr != ~0u)
 	{
-		bool ismeta = Array->ExprType == EFX_ClassMember && static_cast<FxClassMember*>(Array)->membervar->Flags & VARF_Meta;
-
 		arrayvar.Free(build);
 		start = ExpEmit(build, REGT_POINTER);
 		build->Emit(OP_LP, start.RegNum, arrayvar.RegNum, build->GetConstantInt(0));
 
-		auto f = Create<PField>(NAME_None, TypeUInt32, ismeta? VARF_Meta : 0, SizeAddr);
-		static_cast<FxMemberBase *>(Array)->membervar = f;
+		static_cast<FxMemberBase *>(Array)->membervar = SizeField;
 		static_cast<FxMemberBase *>(Array)->AddressRequested = false;
 		Array->ValueType = TypeUInt32;
 		bound = Array->Emit(build);
@@ -8187,7 +8209,7 @@ FxExpression *FxMemberFunctionCall::Resolve(FCompileContext& ctx)
 					if (Self->ExprType == EFX_StructMember || Self->ExprType == EFX_ClassMember || Self->ExprType == EFX_StackVariable)
 					{
 						auto member = static_cast<FxMemberBase*>(Self);
-						auto newfield = Create<PField>(NAME_None, backingtype, 0, member->membervar->Offset);
+						auto newfield = CreateCodeField(NAME_None, backingtype, 0, member->membervar->Offset);
 						member->membervar = newfield;
 					}
 				}
@@ -8232,7 +8254,7 @@ FxExpression *FxMemberFunctionCall::Resolve(FCompileContext& ctx)
 				if (Self->ExprType == EFX_StructMember || Self->ExprType == EFX_ClassMember || Self->ExprType == EFX_GlobalVariable)
 				{
 					auto member = static_cast<FxMemberBase*>(Self);
-					auto newfield = Create<PField>(NAME_None, TypeUInt32, VARF_ReadOnly, member->membervar->Offset + sizeof(void*));	// the size is stored right behind the pointer.
+					auto newfield = CreateCodeField(NAME_None, TypeUInt32, VARF_ReadOnly, member->membervar->Offset + sizeof(void*));	// the size is stored right behind the pointer.
 					member->membervar = newfield;
 					Self = nullptr;
 					delete this;
@@ -8593,7 +8615,7 @@ ExpEmit FxActionSpecialCall::Emit(VMFunctionBuilder *build)
 			}
 		}
 	}
-	ArgList.DeleteAndClear();
+	build->DeleteLater(ArgList);
 	ArgList.ShrinkToFit();
 
 	emitters.AddReturn(REGT_INT);
@@ -8992,7 +9014,7 @@ ExpEmit FxVMFunctionCall::Emit(VMFunctionBuilder *build)
 		ExpEmit reg;
 		if (CheckEmitCast(build, false, reg))
 		{
-			ArgList.DeleteAndClear();
+			build->DeleteLater(ArgList);
 			ArgList.ShrinkToFit();
 			return reg;
 		}
@@ -9073,7 +9095,7 @@ ExpEmit FxVMFunctionCall::Emit(VMFunctionBuilder *build)
 			break;
 		}
 	}
-	ArgList.DeleteAndClear();
+	build->DeleteLater(ArgList);
 	ArgList.ShrinkToFit();
 
 	if (!staticcall) emitters.SetVirtualReg(selfemit.RegNum);
@@ -9217,7 +9239,7 @@ ExpEmit FxFlopFunctionCall::Emit(VMFunctionBuilder *build)
 	}
 
 	build->Emit(OP_FLOP, to.RegNum, from.RegNum, FxFlops[Index].Flop);
-	ArgList.DeleteAndClear();
+	build->DeleteLater(ArgList);
 	ArgList.ShrinkToFit();
 	return to;
 }
@@ -9933,7 +9955,7 @@ ExpEmit FxSwitchStatement::Emit(VMFunctionBuilder *build)
 		build->BackpatchToHere(addr->Address);
 	}
 	if (!defaultset) build->BackpatchToHere(DefaultAddress);
-	Content.DeleteAndClear();
+	build->DeleteLater(Content);
 	Content.ShrinkToFit();
 	return ExpEmit();
 }
@@ -11264,7 +11286,7 @@ ExpEmit FxLocalVariableDeclaration::Emit(VMFunctionBuilder *build)
 					break;
 				}
 				case REGT_STRING:
-					build->Emit(OP_LKS, RegNum, build->GetConstantString(constval->GetValue().GetString()));
+					build->Emit(OP_LKS, RegNum, build->GetConstantString(constval->GetValue().GetStringCopy()));
 				}
 				emitval.Free(build);
 			}
@@ -11392,7 +11414,7 @@ ExpEmit FxStaticArray::Emit(VMFunctionBuilder *build)
 	case REGT_STRING:
 	{
 		TArray<FString> cvalues;
-		for (auto v : values) cvalues.Push(static_cast<FxConstant *>(v)->GetValue().GetString());
+		for (auto v : values) cvalues.Push(static_cast<FxConstant *>(v)->GetValue().GetStringCopy());
 		StackOffset = build->AllocConstantsString(cvalues.Size(), &cvalues[0]);
 		break;
 	}
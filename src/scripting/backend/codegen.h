@@ -61,6 +61,7 @@ class VMFunctionBuilder;
 class FxJumpStatement;
 
 extern FMemArena FxAlloc;
+void ReleaseCodeFields();
 
 //==========================================================================
 //
@@ -200,6 +201,12 @@ struct ExpVal
 		return Type == TypeString ? *(FString *)&pointer : Type == TypeName ? FString(FName(ENamedName(Int)).GetChars()) : "";
 	}
 
+	// Unlike GetString this never shares the character buffer, so the result may be used on a different thread than this value.
+	FString GetStringCopy() const
+	{
+		return Type == TypeString ? FString(((FString *)&pointer)->GetChars(), ((FString *)&pointer)->Len()) : GetString();
+	}
+
 	bool GetBool() const
 	{
 		int regtype = Type->GetRegType();
@@ -546,7 +553,7 @@ public:
 		return true;
 	}
 
-	ExpVal GetValue() const
+	const ExpVal &GetValue() const
 	{
 		return value;
 	}
@@ -1516,6 +1523,7 @@ public:
 	FxExpression *Array;
 	FxExpression *index;
 	size_t SizeAddr;
+	PField *SizeField = nullptr;
 	bool AddressRequested;
 	bool AddressWritable;
 	bool arrayispointer = false;
@@ -36,7 +36,14 @@
 #include "codegen.h"
 #include "m_argv.h"
 #include "c_cvars.h"
+#include "stats.h"
 #include "scripting/vm/jit.h"
+#include "doomtype.h"
+#include "p_loadtasks.h"
+#include "ctpl.h"
+
+#include <atomic>
+#include <exception>
 
 struct VMRemap
 {
@@ -71,6 +78,22 @@ VMFunctionBuilder::VMFunctionBuilder(int numimplicits)
 
 VMFunctionBuilder::~VMFunctionBuilder()
 {
+	for (auto node : DeadNodes)
+	{
+		delete node;
+	}
+}
+
+//==========================================================================
+//
+// VMFunctionBuilder :: DeleteLater
+//
+//==========================================================================
+
+void VMFunctionBuilder::DeleteLater(TArray<FxExpression *> &nodes)
+{
+	DeadNodes.Append(nodes);
+	nodes.Clear();
 }
 
 //==========================================================================
@@ -109,6 +132,7 @@ void VMFunctionBuilder::EndStatement()
 
 void VMFunctionBuilder::MakeFunction(VMScriptFunction *func)
 {
+	Fuse();
 	func->Alloc(Code.Size(), IntConstantList.Size(), FloatConstantList.Size(), StringConstantList.Size(), AddressConstantList.Size(), LineNumbers.Size());
 
 	// Copy code block.
@@ -147,6 +171,43 @@ void VMFunctionBuilder::MakeFunction(VMScriptFunction *func)
 	assert(ActiveParam == 0);
 }
 
+//==========================================================================
+//
+// VMFunctionBuilder :: Fuse
+//
+// Peephole pass for the interpreter: replaces the first instruction of a
+// few common pairs with a superinstruction that runs both with a single
+// dispatch. The second instruction stays where it is, so branches into it
+// and the line table are unaffected. The JIT gains nothing from this, so
+// it is skipped when the JIT is used.
+//
+//==========================================================================
+
+EXTERN_CVAR(Bool, vm_jit)
+CVAR(Bool, vm_fuseops, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// takes effect on the next start
+
+void VMFunctionBuilder::Fuse()
+{
+	if (vm_jit || !vm_fuseops) return;
+
+	for (unsigned i = 0; i + 1 < Code.Size(); i++)
+	{
+		VMOP &op = Code[i];
+		int next = Code[i + 1].op;
+
+		if (next == OP_EQ_K)
+		{
+			if (op.op == OP_LW) op.op = OP_LW_EQ;
+			else if (op.op == OP_LBU) op.op = OP_LBU_EQ;
+			else if (op.op == OP_LBIT) op.op = OP_LBIT_EQ;
+		}
+		else if (next == OP_CALL_K && op.op == OP_PARAM)
+		{
+			op.op = OP_PARAM_CALL;
+		}
+	}
+}
+
 //==========================================================================
 //
 // VMFunctionBuilder :: FillIntConstants
@@ -759,6 +820,33 @@ void VMFunctionBuilder::BackpatchListToHere(TArray<size_t> &locs)
 //==========================================================================
 FFunctionBuildList FunctionBuildList;
 
+// Optionally, the code of actor classes is only generated when one of their
+// functions is first called or the class is first spawned, or in small slices
+// between tics. Takes effect on the next start.
+// This is off by default: generating a large class mid-game can take longer
+// than a tic, and code generation errors of deferred classes only show up
+// then and abort the game instead of being reported at startup. Developer
+// mode always generates everything up front.
+CVAR(Bool, vm_lazycode, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+EXTERN_CVAR(Int, developer)
+
+// How long the deferred code generation may take per tic.
+static const double LAZY_CODE_TIC_BUDGET_MS = 0.5;
+
+// After everything has been resolved the function bodies are emitted on
+// all cores. Takes effect on the next start.
+CVAR(Bool, vm_parallelemit, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+// With fewer functions than this, starting the threads costs more than it saves.
+static const unsigned PARALLEL_EMIT_MIN_FUNCTIONS = 64;
+
+// Argument registers are allocated before anything else, so a deferred function gets the same ones when it is emitted.
+static int AllocArgRegister(VMFunctionBuilder &build, PType *type, uint32_t flags)
+{
+	if (!(flags & VARF_Out)) return build.Registers[type->GetRegType()].Get(type->GetRegCount());
+	else return build.Registers[REGT_POINTER].Get(1);
+}
+
 VMFunction *FFunctionBuildList::AddFunction(PNamespace *gnspc, const VersionInfo &ver, PFunction *functype, FxExpression *code, const FString &name, bool fromdecorate, int stateindex, int statecount, int lumpnum)
 {
 	auto func = code->GetDirectFunction(functype, ver);
@@ -810,16 +898,40 @@ void FFunctionBuildList::Build()
 	FILE *dump = nullptr;
 
 	if (Args->CheckParm("-dumpdisasm")) dump = fopen("disasm.txt", "w");
+	const bool lazy = vm_lazycode && developer == DMSG_OFF && dump == nullptr && !Args->CheckParm("-dumpjit");
+
+	// With -scripttimes, report where code generation spends its time and which functions are the most expensive to build.
+	const bool scripttimes = !!Args->CheckParm("-scripttimes");
+	cycle_t resolvetime, emittime;
+	TArray<std::pair<double, unsigned>> functiontimes;
+	resolvetime.Reset();
+	emittime.Reset();
 
+	struct EmitJob
+	{
+		unsigned Index;
+		VMFunctionBuilder *Builder;
+		TArray<FxLocalVariableDeclaration *> Args;	// the code refers to these until it is emitted
+		double Time;
+		FString Error;
+		std::exception_ptr Exception;
+		TArray<FScriptMessage> Messages;	// printed on the main thread, in order
+	};
+	TArray<EmitJob> jobs;
+
+	// Everything gets resolved first. This creates types and symbols, so it has to be done on the main thread.
 	for (auto &item : mItems)
 	{
 		assert(item.Code != NULL);
+		cycle_t itemtime;
+		itemtime.Reset();
+		itemtime.Clock();
 
 		// We don't know the return type in advance for anonymous functions.
 		FCompileContext ctx(item.CurGlobals, item.Func, item.Func->SymbolName == NAME_None ? nullptr : item.Func->Variants[0].Proto, item.FromDecorate, item.StateIndex, item.StateCount, item.Lump, item.Version);
 
 		// Allocate registers for the function's arguments and create local variable nodes before starting to resolve it.
-		VMFunctionBuilder buildit(item.Func->GetImplicitArgs());
+		auto buildit = new VMFunctionBuilder(item.Func->GetImplicitArgs());
 		for (unsigned i = 0; i < item.Func->Variants[0].Proto->ArgumentTypes.Size(); i++)
 		{
 			auto type = item.Func->Variants[0].Proto->ArgumentTypes[i];
@@ -827,20 +939,14 @@ void FFunctionBuildList::Build()
 			auto flags = item.Func->Variants[0].ArgFlags[i];
 			// this won't get resolved and won't get emitted. It is only needed so that the code generator can retrieve the necessary info about this argument to do its work.
 			auto local = new FxLocalVariableDeclaration(type, name, nullptr, flags, FScriptPosition());
-			if (!(flags & VARF_Out)) local->RegNum = buildit.Registers[type->GetRegType()].Get(type->GetRegCount());
-			else local->RegNum = buildit.Registers[REGT_POINTER].Get(1);
+			local->RegNum = AllocArgRegister(*buildit, type, flags);
 			ctx.FunctionArgs.Push(local);
 		}
 
 		FScriptPosition::StrictErrors = !item.FromDecorate;
+		resolvetime.Clock();
 		item.Code = item.Code->Resolve(ctx);
-		// If we need extra space, load the frame pointer into a register so that we do not have to call the wasteful LFP instruction more than once.
-		if (item.Function->ExtraSpace > 0)
-		{
-			buildit.FramePointer = ExpEmit(&buildit, REGT_POINTER);
-			buildit.FramePointer.Fixed = true;
-			buildit.Emit(OP_LFP, buildit.FramePointer.RegNum);
-		}
+		resolvetime.Unclock();
 
 		// Make sure resolving it didn't obliterate it.
 		if (item.Code != nullptr)
@@ -857,6 +963,7 @@ void FFunctionBuildList::Build()
 			if (item.Proto == nullptr)
 			{
 				item.Code->ScriptPosition.Message(MSG_ERROR, "Function %s without prototype", item.PrintableName.GetChars());
+				delete buildit;
 				continue;
 			}
 
@@ -869,41 +976,130 @@ void FFunctionBuildList::Build()
 				sfunc->ArgFlags = item.Func->Variants[0].ArgFlags;
 			}
 
-			// Emit code
-			try
+			sfunc->NumArgs = 0;
+			// NumArgs for the VMFunction must be the amount of stack elements, which can differ from the amount of logical function arguments if vectors are in the list.
+			// For the VM a vector is 2 or 3 args, depending on size.
+			for (auto s : item.Func->Variants[0].Proto->ArgumentTypes)
 			{
-				sfunc->SourceFileName = item.Code->ScriptPosition.FileName;	// remember the file name for printing error messages if something goes wrong in the VM.
-				buildit.BeginStatement(item.Code);
-				item.Code->Emit(&buildit);
-				buildit.EndStatement();
-				buildit.MakeFunction(sfunc);
-				sfunc->NumArgs = 0;
-				// NumArgs for the VMFunction must be the amount of stack elements, which can differ from the amount of logical function arguments if vectors are in the list.
-				// For the VM a vector is 2 or 3 args, depending on size.
-				for (auto s : item.Func->Variants[0].Proto->ArgumentTypes)
-				{
-					sfunc->NumArgs += s->GetRegCount();
-				}
+				sfunc->NumArgs += s->GetRegCount();
+			}
+			sfunc->Unsafe = ctx.Unsafe;
 
-				if (dump != nullptr)
+			PClassType *owner = PType::toClass(item.Func->OwningClass);
+			if (lazy && owner != nullptr && owner->Descriptor->TypeName != NAME_Actor && owner->Descriptor->IsDescendantOf(NAME_Actor))
+			{
+				// The resolved code refers to the argument declarations, so they have to stay around with it.
+				item.Args = ctx.FunctionArgs;
+				ctx.FunctionArgs.Clear();
+				// State action functions are anonymous and in no symbol table, so a level change's full GC would free them before the code gets generated.
+				if (!(item.Func->ObjectFlags & OF_Fixed))
 				{
-					DumpFunction(dump, sfunc, item.PrintableName.GetChars(), (int)item.PrintableName.Len());
-					codesize += sfunc->CodeSize;
-					datasize += sfunc->LineInfoCount * sizeof(FStatementInfo) + sfunc->ExtraSpace + sfunc->NumKonstD * sizeof(int) +
-						sfunc->NumKonstA * sizeof(void*) + sfunc->NumKonstF * sizeof(double) + sfunc->NumKonstS * sizeof(FString);
+					item.Func->ObjectFlags |= OF_Fixed;
+					item.PinnedFunc = true;
 				}
-				sfunc->Unsafe = ctx.Unsafe;
+				sfunc->PendingClass = owner->Descriptor;
+				owner->Descriptor->bCodePending = true;
+				mDeferred[owner->Descriptor].Push(item);
+				mDeferredFunctions++;
+				item.Code = nullptr;
+			}
+			else
+			{
+				itemtime.Unclock();
+				jobs.Push({ unsigned(&item - &mItems[0]), buildit, ctx.FunctionArgs, itemtime.TimeMS() });
+				ctx.FunctionArgs.Clear();
+				continue;
+			}
+		}
+		delete buildit;
+		delete item.Code;
+		itemtime.Unclock();
+		if (scripttimes)
+		{
+			functiontimes.Push(std::make_pair(itemtime.TimeMS(), unsigned(&item - &mItems[0])));
+		}
+	}
+
+	// Each resolved function is emitted into its own builder, which only touches the function's own code tree.
+	// So this part gets spread over the loader's thread pool, taking the functions in order from a shared counter.
+	std::atomic<unsigned> nextjob(0);
+	auto emitjobs = [&]()
+	{
+		for (unsigned i; (i = nextjob++) < jobs.Size(); )
+		{
+			auto &job = jobs[i];
+			auto &item = mItems[job.Index];
+			cycle_t jobtime;
+			jobtime.Reset();
+			jobtime.Clock();
+			FScriptPosition::MessageBuffer = &job.Messages;
+			FScriptPosition::StrictErrors = !item.FromDecorate;
+			try
+			{
+				EmitCode(item, *job.Builder);
 			}
 			catch (CRecoverableError &err)
 			{
-				// catch errors from the code generator and pring something meaningful.
-				item.Code->ScriptPosition.Message(MSG_ERROR, "%s in %s", err.GetMessage(), item.PrintableName.GetChars());
+				job.Error = err.GetMessage();
+			}
+			catch (...)
+			{
+				// Fatal errors must reach the main thread.
+				job.Exception = std::current_exception();
 			}
+			FScriptPosition::MessageBuffer = nullptr;
+			FScriptPosition::StrictErrors = false;
+			jobtime.Unclock();
+			job.Time += jobtime.TimeMS();
 		}
+	};
+
+	const bool parallel = vm_parallelemit && jobs.Size() >= PARALLEL_EMIT_MIN_FUNCTIONS;
+	const unsigned numworkers = parallel ? FLoadTaskGraph::Pool().size() : 0;
+	FLoadTaskGraph emitgraph;
+	for (unsigned i = 0; i < numworkers; i++)
+	{
+		emitgraph.AddTask("Emit functions", emitjobs, FLoadTaskGraph::Worker);
+	}
+	emitgraph.AddTask("Emit functions", emitjobs);
+	emittime.Clock();
+	emitgraph.Run(parallel);
+	emittime.Unclock();
+
+	// Finish the functions in their original order, so that messages, the disassembly dump and the class data allocations come out the same as with a single thread.
+	for (auto &job : jobs)
+	{
+		auto &item = mItems[job.Index];
+		VMScriptFunction *sfunc = item.Function;
+		FScriptPosition::PrintMessages(job.Messages);
+		if (job.Exception)
+		{
+			std::rethrow_exception(job.Exception);
+		}
+		if (job.Error.IsNotEmpty())
+		{
+			// catch errors from the code generator and pring something meaningful.
+			item.Code->ScriptPosition.Message(MSG_ERROR, "%s in %s", job.Error.GetChars(), item.PrintableName.GetChars());
+		}
+		else
+		{
+			sfunc->SourceFileName = item.Code->ScriptPosition.FileName;	// remember the file name for printing error messages if something goes wrong in the VM.
+			job.Builder->MakeFunction(sfunc);
+			if (dump != nullptr)
+			{
+				DumpFunction(dump, sfunc, item.PrintableName.GetChars(), (int)item.PrintableName.Len());
+				codesize += sfunc->CodeSize;
+				datasize += sfunc->LineInfoCount * sizeof(FStatementInfo) + sfunc->ExtraSpace + sfunc->NumKonstD * sizeof(int) +
+					sfunc->NumKonstA * sizeof(void*) + sfunc->NumKonstF * sizeof(double) + sfunc->NumKonstS * sizeof(FString);
+				fflush(dump);
+			}
+		}
+		delete job.Builder;
 		delete item.Code;
-		if (dump != nullptr)
+		for (auto arg : job.Args) delete arg;
+		if (scripttimes)
 		{
-			fflush(dump);
+			functiontimes.Push(std::make_pair(job.Time, job.Index));
 		}
 	}
 	if (dump != nullptr)
@@ -914,10 +1110,211 @@ void FFunctionBuildList::Build()
 	VMFunction::CreateRegUseInfo();
 	FScriptPosition::StrictErrors = false;
 
+	if (scripttimes)
+	{
+		Printf("%u functions: resolve %.2f ms, emit %.2f ms on %u threads\n", mItems.Size(), resolvetime.TimeMS(), emittime.TimeMS(), numworkers + 1);
+		std::sort(functiontimes.begin(), functiontimes.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+		for (unsigned i = 0; i < MIN(functiontimes.Size(), 10u); i++)
+		{
+			Printf("  %8.3f ms  %s\n", functiontimes[i].first, mItems[functiontimes[i].second].PrintableName.GetChars());
+		}
+	}
+
+	if (mDeferred.CountUsed() > 0 && !batchrun)
+	{
+		Printf("%u functions in %u actor classes will be generated on first use or between tics\n", mDeferredFunctions, mDeferred.CountUsed());
+	}
+
 	if (FScriptPosition::ErrorCounter == 0 && Args->CheckParm("-dumpjit")) DumpJit();
 	mItems.Clear();
 	mItems.ShrinkToFit();
+	// The deferred functions' code trees live in FxAlloc as well.
+	if (mDeferred.CountUsed() == 0)
+	{
+		FxAlloc.FreeAllBlocks();
+		ReleaseCodeFields();
+	}
+}
+
+//==========================================================================
+//
+// FFunctionBuildList :: EmitCode
+//
+// Generates the code for a resolved function into the builder, which must
+// already have the argument registers allocated. This only works on the
+// function's own code tree and builder, so it may run on any thread.
+//
+//==========================================================================
+
+void FFunctionBuildList::EmitCode(Item &item, VMFunctionBuilder &buildit)
+{
+	VMScriptFunction *sfunc = item.Function;
+
+	// If we need extra space, load the frame pointer into a register so that we do not have to call the wasteful LFP instruction more than once.
+	if (sfunc->ExtraSpace > 0)
+	{
+		buildit.FramePointer = ExpEmit(&buildit, REGT_POINTER);
+		buildit.FramePointer.Fixed = true;
+		buildit.Emit(OP_LFP, buildit.FramePointer.RegNum);
+	}
+
+	buildit.BeginStatement(item.Code);
+	item.Code->Emit(&buildit);
+	buildit.EndStatement();
+}
+
+//==========================================================================
+//
+// FFunctionBuildList :: EmitFunction
+//
+// Generates the code for a resolved function and stores it in the
+// function object.
+//
+//==========================================================================
+
+bool FFunctionBuildList::EmitFunction(Item &item, VMFunctionBuilder &buildit)
+{
+	VMScriptFunction *sfunc = item.Function;
+
+	try
+	{
+		sfunc->SourceFileName = item.Code->ScriptPosition.FileName;	// remember the file name for printing error messages if something goes wrong in the VM.
+		EmitCode(item, buildit);
+		buildit.MakeFunction(sfunc);
+		return true;
+	}
+	catch (CRecoverableError &err)
+	{
+		// catch errors from the code generator and pring something meaningful.
+		item.Code->ScriptPosition.Message(MSG_ERROR, "%s in %s", err.GetMessage(), item.PrintableName.GetChars());
+		return false;
+	}
+}
+
+//==========================================================================
+//
+// FFunctionBuildList :: FinishClass
+//
+// Generates all deferred code of a class and its ancestors.
+//
+//==========================================================================
+
+void FFunctionBuildList::FinishClass(PClass *cls)
+{
+	for (; cls != nullptr; cls = cls->ParentClass)
+	{
+		if (!cls->bCodePending) continue;
+		cls->bCodePending = false;
+
+		auto pending = mDeferred.CheckKey(cls);
+		if (pending == nullptr) continue;
+		TArray<Item> items = std::move(*pending);
+		mDeferred.Remove(cls);
+		mFinishedClasses++;
+
+		for (auto &item : items)
+		{
+			VMFunctionBuilder buildit(item.Func->GetImplicitArgs());
+			auto &proto = item.Func->Variants[0];
+			for (unsigned i = 0; i < proto.Proto->ArgumentTypes.Size(); i++)
+			{
+				int reg = AllocArgRegister(buildit, proto.Proto->ArgumentTypes[i], proto.ArgFlags[i]);
+				assert(reg == item.Args[i]->RegNum);
+			}
+
+			int errors = FScriptPosition::ErrorCounter;
+			FScriptPosition::StrictErrors = !item.FromDecorate;
+			item.Function->PendingClass = nullptr;
+			EmitFunction(item, buildit);
+			FScriptPosition::StrictErrors = false;
+			if (FScriptPosition::ErrorCounter > errors)
+			{
+				I_Error("Code generation for %s failed (it was deferred, start with developer mode on to check all code at load)", item.PrintableName.GetChars());
+			}
+			delete item.Code;
+			for (auto arg : item.Args) delete arg;
+			if (item.PinnedFunc) item.Func->ObjectFlags &= ~OF_Fixed;
+			JitWarmUpFunction(item.Function);
+		}
+	}
+	if (mDeferred.CountUsed() == 0)
+	{
+		FxAlloc.FreeAllBlocks();
+		ReleaseCodeFields();
+	}
+}
+
+//==========================================================================
+//
+// FFunctionBuildList :: FinishSome
+//
+// Generates deferred classes for up to the given time, so that the
+// resolved code trees do not have to be kept for the entire session.
+//
+//==========================================================================
+
+void FFunctionBuildList::FinishSome(double budgetms)
+{
+	if (mDeferred.CountUsed() == 0) return;
+
+	cycle_t timer;
+	timer.Reset();
+	timer.Clock();
+	do
+	{
+		TMap<PClass *, TArray<Item>>::Iterator it(mDeferred);
+		TMap<PClass *, TArray<Item>>::Pair *pair;
+		if (!it.NextPair(pair)) break;
+		FinishClass(pair->Key);
+		timer.Unclock();
+		timer.Clock();
+	} while (timer.TimeMS() < budgetms);
+	timer.Unclock();
+}
+
+//==========================================================================
+//
+// FFunctionBuildList :: DropDeferred
+//
+// Discards the code that never got generated, before the types it
+// refers to go away.
+//
+//==========================================================================
+
+void FFunctionBuildList::DropDeferred()
+{
+	TMap<PClass *, TArray<Item>>::Iterator it(mDeferred);
+	TMap<PClass *, TArray<Item>>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		for (auto &item : pair->Value)
+		{
+			delete item.Code;
+			for (auto arg : item.Args) delete arg;
+			if (item.PinnedFunc) item.Func->ObjectFlags &= ~OF_Fixed;
+		}
+	}
+	mDeferred.Clear();
+	mDeferredFunctions = mFinishedClasses = 0;
 	FxAlloc.FreeAllBlocks();
+	ReleaseCodeFields();
+}
+
+void VMFinishDeferred(PClass *cls)
+{
+	FunctionBuildList.FinishClass(cls);
+}
+
+void VMFinishSomeDeferred()
+{
+	FunctionBuildList.FinishSome(LAZY_CODE_TIC_BUDGET_MS);
+}
+
+ADD_STAT(lazycode)
+{
+	FString out;
+	out.Format("Deferred actor classes: %u generated, %u pending", FunctionBuildList.FinishedClasses(), FunctionBuildList.PendingClasses());
+	return out;
 }
 
 void FFunctionBuildList::DumpJit()
@@ -1042,14 +1439,15 @@ void FunctionCallEmitter::AddParameterStringConst(const FString &konst)
 	numparams++;
 	if (target->VarFlags & VARF_VarArg)
 		reginfo.Push(REGT_STRING);
+	// The constant usually comes from the called function's defaults, which all callers share.
+	FString str(konst.GetChars(), konst.Len());
 	emitters.push_back([=](VMFunctionBuilder *build) ->int
 	{
-		build->Emit(OP_PARAM, REGT_STRING | REGT_KONST, build->GetConstantString(konst));
+		build->Emit(OP_PARAM, REGT_STRING | REGT_KONST, build->GetConstantString(str));
 		return 1;
 	});
 }
 
-EXTERN_CVAR(Bool, vm_jit)
 
 ExpEmit FunctionCallEmitter::EmitCall(VMFunctionBuilder *build, TArray<ExpEmit> *ReturnRegs)
 {
@@ -84,9 +84,16 @@ public:
 	void FillAddressConstants(FVoidObj *konst);
 	void FillStringConstants(FString *strings);
 
+	// Peephole pass that turns common instruction pairs into superinstructions.
+	void Fuse();
+
 	// PARAM increases ActiveParam; CALL decreases it.
 	void ParamChange(int delta);
 
+	// Takes code nodes Emit is done with. They get deleted along with the builder, because
+	// their destructors release strings that other functions' code trees may be sharing.
+	void DeleteLater(TArray<FxExpression *> &nodes);
+
 	// Track available registers.
 	RegAvailability Registers[4];
 
@@ -100,6 +107,7 @@ public:
 private:
 	TArray<FStatementInfo> LineNumbers;
 	TArray<FxExpression *> StatementStack;
+	TArray<FxExpression *> DeadNodes;
 
 	TArray<int> IntConstantList;
 	TArray<double> FloatConstantList;
@@ -143,15 +151,28 @@ class FFunctionBuildList
 		int Lump;
 		VersionInfo Version;
 		bool FromDecorate;
+		TArray<FxLocalVariableDeclaration *> Args;	// only kept for deferred functions
+		bool PinnedFunc = false;	// Func was fixed against the GC while deferred
 	};
 
 	TArray<Item> mItems;
+	TMap<PClass *, TArray<Item>> mDeferred;		// resolved functions of actor classes, waiting for FinishClass
+	unsigned mDeferredFunctions = 0;
+	unsigned mFinishedClasses = 0;
 
 	void DumpJit();
+	void EmitCode(Item &item, VMFunctionBuilder &buildit);
+	bool EmitFunction(Item &item, VMFunctionBuilder &buildit);
 
 public:
 	VMFunction *AddFunction(PNamespace *curglobals, const VersionInfo &ver, PFunction *func, FxExpression *code, const FString &name, bool fromdecorate, int currentstate, int statecnt, int lumpnum);
 	void Build();
+	void FinishClass(PClass *cls);
+	void FinishSome(double budgetms);
+	void DropDeferred();
+
+	unsigned FinishedClasses() const { return mFinishedClasses; }
+	unsigned PendingClasses() const { return mDeferred.CountUsed(); }
 };
 
 extern FFunctionBuildList FunctionBuildList;
@@ -292,7 +292,7 @@ void VMDisasm(FILE *out, const VMOP *code, int codesize, const VMScriptFunction
 			a &= CMP_CHECK | CMP_APPROX;
 			cmp = true;
 		}
-		if (code[i].op == OP_PARAM && code[i].a & REGT_ADDROF)
+		if ((code[i].op == OP_PARAM || code[i].op == OP_PARAM_CALL) && code[i].a & REGT_ADDROF)
 		{
 			name = "parama";
 		}
@@ -341,6 +341,7 @@ void VMDisasm(FILE *out, const VMOP *code, int codesize, const VMScriptFunction
 		}
 
 		case OP_PARAM:
+		case OP_PARAM_CALL:
 		{
 			col = print_reg(out, col, code[i].i24 & 0xffffff, MODE_PARAM24, 16, func);
 			break;
@@ -51,6 +51,8 @@
 #include "v_text.h"
 #include "backend/codegen.h"
 #include "stats.h"
+#include "m_argv.h"
+#include "vm/jit.h"
 #include "info.h"
 #include "thingdef.h"
 
@@ -432,19 +434,29 @@ void SynthesizeFlagFields();
 void LoadActors()
 {
 	cycle_t timer;
+	// Stage times for -scripttimes: ZScript front end, DECORATE, code generation, postprocessing.
+	cycle_t stagetimes[4];
+	for (auto &t : stagetimes) t.Reset();
 
 	timer.Reset(); timer.Clock();
 	FScriptPosition::ResetErrorCounter();
 
 	InitThingdef();
 	FScriptPosition::StrictErrors = true;
+	stagetimes[0].Clock();
 	ParseScripts();
+	stagetimes[0].Unclock();
 
 	FScriptPosition::StrictErrors = false;
+	stagetimes[1].Clock();
 	ParseAllDecorate();
 	SynthesizeFlagFields();
+	stagetimes[1].Unclock();
 
+	stagetimes[2].Clock();
 	FunctionBuildList.Build();
+	stagetimes[2].Unclock();
+	stagetimes[3].Clock();
 
 	if (FScriptPosition::ErrorCounter > 0)
 	{
@@ -505,10 +517,17 @@ void LoadActors()
 		I_Error("%d errors during actor postprocessing", FScriptPosition::ErrorCounter);
 	}
 
+	stagetimes[3].Unclock();
 	timer.Unclock();
 	if (!batchrun) Printf("script parsing took %.2f ms\n", timer.TimeMS());
+	if (Args->CheckParm("-scripttimes"))
+	{
+		Printf("ZScript %.2f ms, DECORATE %.2f ms, code generation %.2f ms, postprocessing %.2f ms\n",
+			stagetimes[0].TimeMS(), stagetimes[1].TimeMS(), stagetimes[2].TimeMS(), stagetimes[3].TimeMS());
+	}
 
 	// Now we may call the scripted OnDestroy method.
 	PClass::bVMOperational = true;
 	StateSourceLines.Clear();
+	JitWarmUp();
 }
@@ -8,7 +8,7 @@ extern PStruct *TypeVector3;
 
 static void OutputJitLog(const asmjit::StringLogger &logger);
 
-JitFuncPtr JitCompile(VMScriptFunction *sfunc)
+JitFuncPtr JitCompile(VMScriptFunction *sfunc, FString *error)
 {
 #if 0
 	if (strcmp(sfunc->PrintableName.GetChars(), "StatusScreen.drawNum") != 0)
@@ -16,6 +16,7 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 #endif
 
 	using namespace asmjit;
+	std::lock_guard<std::mutex> lock(JitMutex);
 	StringLogger logger;
 	try
 	{
@@ -30,6 +31,12 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 	}
 	catch (const CRecoverableError &e)
 	{
+		// Not on the main thread, so leave the reporting to the caller.
+		if (error != nullptr)
+		{
+			*error = e.what();
+			return nullptr;
+		}
 		OutputJitLog(logger);
 		Printf("%s: Unexpected JIT error: %s\n",sfunc->PrintableName.GetChars(), e.what());
 		return nullptr;
@@ -39,6 +46,7 @@ JitFuncPtr JitCompile(VMScriptFunction *sfunc)
 void JitDumpLog(FILE *file, VMScriptFunction *sfunc)
 {
 	using namespace asmjit;
+	std::lock_guard<std::mutex> lock(JitMutex);
 	StringLogger logger;
 	try
 	{
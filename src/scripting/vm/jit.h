@@ -3,6 +3,9 @@
 
 #include "vmintern.h"
 
-JitFuncPtr JitCompile(VMScriptFunction *func);
+JitFuncPtr JitCompile(VMScriptFunction *func, FString *error = nullptr);
 void JitDumpLog(FILE *file, VMScriptFunction *func);
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames);
+bool JitPCToScriptLine(void *pc, FString &name, FString &filename, int &line);
+void JitWarmUp();
+void JitWarmUpFunction(VMScriptFunction *func);
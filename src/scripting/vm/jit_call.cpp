@@ -13,6 +13,11 @@ void JitCompiler::EmitPARAMI()
 	ParamOpcodes.Push(pc);
 }
 
+void JitCompiler::EmitPARAM_CALL()
+{
+	ParamOpcodes.Push(pc);
+}
+
 void JitCompiler::EmitRESULT()
 {
 	// This instruction is just a placeholder to indicate where a return
@@ -25,8 +30,27 @@ void JitCompiler::EmitVTBL()
 	// This instruction is handled in the CALL/CALL_K instruction following it
 }
 
+// Polymorphic inline cache for a virtual call site: remembers the classes
+// of the last few receivers and the functions their vtables resolved to.
+// Most call sites only see one or two classes (an actor and its
+// replacement, or a handful of related monsters), so a hit replaces the
+// Virtuals array and slot loads with a few compares. A miss moves the
+// entries down and puts the new class first. Megamorphic sites would pay
+// for that on nearly every call, so once a site has missed
+// JitVtblMaxMisses times it goes back to the plain vtable load for good.
+enum { JitVtblCacheSize = 4, JitVtblMaxMisses = 32 };
+
+struct JitVtblCache
+{
+	PClass *Class[JitVtblCacheSize];
+	VMFunction *Func[JitVtblCacheSize];
+	int Misses;
+};
+
 void JitCompiler::EmitVtbl(const VMOP *op)
 {
+	using namespace asmjit;
+
 	int a = op->a;
 	int b = op->b;
 	int c = op->c;
@@ -35,9 +59,54 @@ void JitCompiler::EmitVtbl(const VMOP *op)
 	cc.test(regA[b], regA[b]);
 	cc.jz(label);
 
-	cc.mov(regA[a], asmjit::x86::qword_ptr(regA[b], myoffsetof(DObject, Class)));
-	cc.mov(regA[a], asmjit::x86::qword_ptr(regA[a], myoffsetof(PClass, Virtuals) + myoffsetof(FArray, Array)));
-	cc.mov(regA[a], asmjit::x86::qword_ptr(regA[a], c * (int)sizeof(void*)));
+	auto cache = (JitVtblCache *)AllocJitData(sizeof(JitVtblCache));
+	memset(cache, 0, sizeof(JitVtblCache));
+
+	auto cls = newTempIntPtr();
+	auto cacheptr = newTempIntPtr();
+	Label L_hit[JitVtblCacheSize];
+	Label L_plain = cc.newLabel();
+	Label L_done = cc.newLabel();
+
+	cc.mov(cls, x86::qword_ptr(regA[b], myoffsetof(DObject, Class)));
+	cc.mov(cacheptr, imm_ptr(cache));
+	cc.cmp(x86::dword_ptr(cacheptr, myoffsetof(JitVtblCache, Misses)), JitVtblMaxMisses);
+	cc.jae(L_plain);
+	for (int i = 0; i < JitVtblCacheSize; i++)
+	{
+		L_hit[i] = cc.newLabel();
+		cc.cmp(cls, x86::qword_ptr(cacheptr, myoffsetof(JitVtblCache, Class) + i * (int)sizeof(void*)));
+		cc.je(L_hit[i]);
+	}
+
+	cc.add(x86::dword_ptr(cacheptr, myoffsetof(JitVtblCache, Misses)), 1);
+	cc.mov(regA[a], x86::qword_ptr(cls, myoffsetof(PClass, Virtuals) + myoffsetof(FArray, Array)));
+	cc.mov(regA[a], x86::qword_ptr(regA[a], c * (int)sizeof(void*)));
+	auto tmp = newTempIntPtr();
+	for (int i = JitVtblCacheSize - 1; i > 0; i--)
+	{
+		cc.mov(tmp, x86::qword_ptr(cacheptr, myoffsetof(JitVtblCache, Class) + (i - 1) * (int)sizeof(void*)));
+		cc.mov(x86::qword_ptr(cacheptr, myoffsetof(JitVtblCache, Class) + i * (int)sizeof(void*)), tmp);
+		cc.mov(tmp, x86::qword_ptr(cacheptr, myoffsetof(JitVtblCache, Func) + (i - 1) * (int)sizeof(void*)));
+		cc.mov(x86::qword_ptr(cacheptr, myoffsetof(JitVtblCache, Func) + i * (int)sizeof(void*)), tmp);
+	}
+	cc.mov(x86::qword_ptr(cacheptr, myoffsetof(JitVtblCache, Class)), cls);
+	cc.mov(x86::qword_ptr(cacheptr, myoffsetof(JitVtblCache, Func)), regA[a]);
+	cc.jmp(L_done);
+
+	cc.bind(L_plain);
+	cc.mov(regA[a], x86::qword_ptr(cls, myoffsetof(PClass, Virtuals) + myoffsetof(FArray, Array)));
+	cc.mov(regA[a], x86::qword_ptr(regA[a], c * (int)sizeof(void*)));
+	cc.jmp(L_done);
+
+	for (int i = 0; i < JitVtblCacheSize; i++)
+	{
+		cc.bind(L_hit[i]);
+		cc.mov(regA[a], x86::qword_ptr(cacheptr, myoffsetof(JitVtblCache, Func) + i * (int)sizeof(void*)));
+		if (i + 1 < JitVtblCacheSize) cc.jmp(L_done);
+	}
+
+	cc.bind(L_done);
 }
 
 void JitCompiler::EmitCALL()
@@ -212,7 +281,7 @@ void JitCompiler::LoadInOuts()
 	for (unsigned int i = 0; i < ParamOpcodes.Size(); i++)
 	{
 		const VMOP &param = *ParamOpcodes[i];
-		if (param.op == OP_PARAM && (param.a & REGT_ADDROF))
+		if ((param.op == OP_PARAM || param.op == OP_PARAM_CALL) && (param.a & REGT_ADDROF))
 		{
 			LoadCallResult(param.a, param.i16u, true);
 		}
@@ -146,6 +146,18 @@ void JitCompiler::EmitLBU_R()
 	cc.movzx(regD[A].r8Lo(), asmjit::x86::byte_ptr(regA[B], regD[C]));
 }
 
+// The fused loads only save the interpreter a dispatch. Here the EQ_K after them gets emitted on its own.
+
+void JitCompiler::EmitLW_EQ()
+{
+	EmitLW();
+}
+
+void JitCompiler::EmitLBU_EQ()
+{
+	EmitLBU();
+}
+
 void JitCompiler::EmitLHU()
 {
 	EmitNullPointerThrow(B, X_READ_NIL);
@@ -358,3 +370,8 @@ void JitCompiler::EmitLBIT()
 	cc.cmp(regD[A], 0);
 	cc.setne(regD[A]);
 }
+
+void JitCompiler::EmitLBIT_EQ()
+{
+	EmitLBIT();
+}
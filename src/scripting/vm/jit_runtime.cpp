@@ -25,6 +25,8 @@ static TArray<uint8_t*> JitBlocks;
 static TArray<uint8_t*> JitFrames;
 static size_t JitBlockPos = 0;
 static size_t JitBlockSize = 0;
+static FMemArena JitDataAllocator(4096);	// data referenced by the generated code, released together with it
+std::mutex JitMutex;
 
 asmjit::CodeInfo GetHostCodeInfo()
 {
@@ -65,6 +67,11 @@ static void *AllocJitMemory(size_t size)
 	}
 }
 
+void *AllocJitData(size_t size)
+{
+	return JitDataAllocator.Alloc(size);
+}
+
 #ifdef WIN32
 
 #define UWOP_PUSH_NONVOL 0
@@ -302,7 +309,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 	if (result == 0)
 		I_Error("RtlAddFunctionTable failed");
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	// Copy the names' characters, the reference counts are not thread safe.
+	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName.GetChars(), compiler->GetScriptFunction()->SourceFileName.GetChars(), compiler->LineInfo, startaddr, endaddr });
 #endif
 
 	return p;
@@ -726,7 +734,8 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 #endif
 	}
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	// Copy the names' characters, the reference counts are not thread safe.
+	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName.GetChars(), compiler->GetScriptFunction()->SourceFileName.GetChars(), compiler->LineInfo, startaddr, endaddr });
 
 	return p;
 }
@@ -734,6 +743,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 
 void JitRelease()
 {
+	std::lock_guard<std::mutex> lock(JitMutex);
 #ifdef _WIN64
 	for (auto p : JitFrames)
 	{
@@ -749,6 +759,7 @@ void JitRelease()
 	{
 		asmjit::OSUtils::releaseVirtualMemory(p, 1024 * 1024);
 	}
+	JitDataAllocator.FreeAllBlocks();
 	JitDebugInfo.Clear();
 	JitFrames.Clear();
 	JitBlocks.Clear();
@@ -928,6 +939,7 @@ int JITPCToLine(uint8_t *pc, const JitFuncInfo *info)
 
 FString JitGetStackFrameName(NativeSymbolResolver *nativeSymbols, void *pc)
 {
+	std::lock_guard<std::mutex> lock(JitMutex);
 	for (unsigned int i = 0; i < JitDebugInfo.Size(); i++)
 	{
 		const auto &info = JitDebugInfo[i];
@@ -949,6 +961,24 @@ FString JitGetStackFrameName(NativeSymbolResolver *nativeSymbols, void *pc)
 	return nativeSymbols ? nativeSymbols->GetName(pc) : FString();
 }
 
+// Maps a return address to the script function and line it belongs to. Returns false for native code.
+bool JitPCToScriptLine(void *pc, FString &name, FString &filename, int &line)
+{
+	std::lock_guard<std::mutex> lock(JitMutex);
+	for (unsigned int i = 0; i < JitDebugInfo.Size(); i++)
+	{
+		const auto &info = JitDebugInfo[i];
+		if (pc >= info.start && pc < info.end)
+		{
+			name = info.name;
+			filename = info.filename;
+			line = JITPCToLine((uint8_t *)pc, &info);
+			return true;
+		}
+	}
+	return false;
+}
+
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames)
 {
 	void *frames[32];
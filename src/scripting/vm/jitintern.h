@@ -11,6 +11,7 @@
 #include <asmjit/asmjit.h>
 #include <asmjit/x86.h>
 #include <functional>
+#include <mutex>
 #include <vector>
 
 extern cycle_t VMCycles[10];
@@ -318,5 +319,10 @@ public:
 	}
 };
 
+// Held while compiling and while reading or releasing the generated code's
+// bookkeeping, since functions can be compiled on a background thread.
+extern std::mutex JitMutex;
+
 void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler);
+void *AllocJitData(size_t size);
 asmjit::CodeInfo GetHostCodeInfo();
@@ -54,6 +54,11 @@ extern FMemArena ClassDataAllocator;
 #define MAX_TRY_DEPTH	8	// Maximum number of nested TRYs in a single function
 
 void JitRelease();
+void JitWarmUpRelease();
+void JitInstallBackground();
+void VMProfilerTick();
+void VMFinishDeferred(PClass *cls);
+void VMFinishSomeDeferred();
 
 
 typedef unsigned char		VM_UBYTE;
@@ -429,6 +434,8 @@ public:
 	void operator delete[](void *block) {}
 	static void DeleteAll()
 	{
+		// stop the background compiler and forget the functions it knows about
+		JitWarmUpRelease();
 		for (auto f : AllFunctions)
 		{
 			f->~VMFunction();
@@ -181,6 +181,13 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		GETADDR(PB,RC,X_READ_NIL);
 		reg.d[a] = *(VM_SWORD *)ptr;
 		NEXTOP;
+	OP(LW_EQ):
+		ASSERTD(a); ASSERTA(B); ASSERTKD(C);
+		GETADDR(PB,KC,X_READ_NIL);
+		reg.d[a] = *(VM_SWORD *)ptr;
+		pc++;
+		a = pc->a;
+		goto Do_EQ_K;
 	OP(LBU):
 		ASSERTD(a); ASSERTA(B); ASSERTKD(C);
 		GETADDR(PB,KC,X_READ_NIL);
@@ -191,6 +198,13 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		GETADDR(PB,RC,X_READ_NIL);
 		reg.d[a] = *(VM_UBYTE *)ptr;
 		NEXTOP;
+	OP(LBU_EQ):
+		ASSERTD(a); ASSERTA(B); ASSERTKD(C);
+		GETADDR(PB,KC,X_READ_NIL);
+		reg.d[a] = *(VM_UBYTE *)ptr;
+		pc++;
+		a = pc->a;
+		goto Do_EQ_K;
 	OP(LHU):
 		ASSERTD(a); ASSERTA(B); ASSERTKD(C);
 		GETADDR(PB,KC,X_READ_NIL);
@@ -306,6 +320,13 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		GETADDR(PB,0,X_READ_NIL);
 		reg.d[a] = !!(*(VM_UBYTE *)ptr & C);
 		NEXTOP;
+	OP(LBIT_EQ):
+		ASSERTD(a); ASSERTA(B);
+		GETADDR(PB,0,X_READ_NIL);
+		reg.d[a] = !!(*(VM_UBYTE *)ptr & C);
+		pc++;
+		a = pc->a;
+		goto Do_EQ_K;
 
 	OP(SB):
 		ASSERTA(a); ASSERTD(B); ASSERTKD(C);
@@ -567,87 +588,14 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		NEXTOP;
 	OP(PARAM):
 		assert(f->NumParam < sfunc->MaxParam);
-		{
-			VMValue *param = &reg.param[f->NumParam++];
-			b = BC;
-			if (a == REGT_NIL)
-			{
-				::new(param) VMValue();
-			}
-			else
-			{
-				switch(a)
-				{
-				case REGT_INT:
-					assert(b < f->NumRegD);
-					::new(param) VMValue(reg.d[b]);
-					break;
-				case REGT_INT | REGT_ADDROF:
-					assert(b < f->NumRegD);
-					::new(param) VMValue(&reg.d[b]);
-					break;
-				case REGT_INT | REGT_KONST:
-					assert(b < sfunc->NumKonstD);
-					::new(param) VMValue(konstd[b]);
-					break;
-				case REGT_STRING:
-					assert(b < f->NumRegS);
-					::new(param) VMValue(&reg.s[b]);
-					break;
-				case REGT_STRING | REGT_ADDROF:
-					assert(b < f->NumRegS);
-					::new(param) VMValue((void*)&reg.s[b]);	// Note that this may not use the FString* version of the constructor!
-					break;
-				case REGT_STRING | REGT_KONST:
-					assert(b < sfunc->NumKonstS);
-					::new(param) VMValue(&konsts[b]);
-					break;
-				case REGT_POINTER:
-					assert(b < f->NumRegA);
-					::new(param) VMValue(reg.a[b]);
-					break;
-				case REGT_POINTER | REGT_ADDROF:
-					assert(b < f->NumRegA);
-					::new(param) VMValue(&reg.a[b]);
-					break;
-				case REGT_POINTER | REGT_KONST:
-					assert(b < sfunc->NumKonstA);
-					::new(param) VMValue(konsta[b].v);
-					break;
-				case REGT_FLOAT:
-					assert(b < f->NumRegF);
-					::new(param) VMValue(reg.f[b]);
-					break;
-				case REGT_FLOAT | REGT_MULTIREG2:
-					assert(b < f->NumRegF - 1);
-					assert(f->NumParam < sfunc->MaxParam);
-					::new(param) VMValue(reg.f[b]);
-					::new(param + 1) VMValue(reg.f[b + 1]);
-					f->NumParam++;
-					break;
-				case REGT_FLOAT | REGT_MULTIREG3:
-					assert(b < f->NumRegF - 2);
-					assert(f->NumParam < sfunc->MaxParam - 1);
-					::new(param) VMValue(reg.f[b]);
-					::new(param + 1) VMValue(reg.f[b + 1]);
-					::new(param + 2) VMValue(reg.f[b + 2]);
-					f->NumParam += 2;
-					break;
-				case REGT_FLOAT | REGT_ADDROF:
-					assert(b < f->NumRegF);
-					::new(param) VMValue(&reg.f[b]);
-					break;
-				case REGT_FLOAT | REGT_KONST:
-					assert(b < sfunc->NumKonstF);
-					::new(param) VMValue(konstf[b]);
-					break;
-				default:
-					assert(0);
-					break;
-				}
-			}
-		}
+		DoParam(reg, f, sfunc, a, BC);
 		NEXTOP;
+	OP(PARAM_CALL):
+		assert(f->NumParam < sfunc->MaxParam);
+		DoParam(reg, f, sfunc, a, BC);
+		pc++;
+		a = pc->a;
+		goto Do_CALL_K;
 	OP(VTBL):
 		ASSERTA(a); ASSERTA(B);
 		{
@@ -676,6 +624,7 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		NEXTOP;
 
 	OP(CALL_K):
+	Do_CALL_K:
 		ASSERTKA(a);
 		ptr = konsta[a].o;
 		goto Do_CALL;
@@ -692,6 +641,7 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 
 			b = B;
 			FillReturns(reg, f, returns, pc+1, C);
+			f->PC = pc;
 			if (call->VarFlags & VARF_Native)
 			{
 				try
@@ -714,6 +664,7 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 				numret = sfunc->ScriptCall(sfunc, reg.param + f->NumParam - b, b, returns, C);
 			}
 			assert(numret == C && "Number of parameters returned differs from what was expected by the caller");
+			f->PC = nullptr;
 			f->NumParam -= B;
 			pc += C;			// Skip RESULTs
 		}
@@ -1200,6 +1151,7 @@ static int ExecScriptFunc(VMFrameStack *stack, VMReturn *ret, int numret)
 		CMPJMP(reg.d[B] == reg.d[C]);
 		NEXTOP;
 	OP(EQ_K):
+	Do_EQ_K:
 		ASSERTD(B); ASSERTKD(C);
 		CMPJMP(reg.d[B] == konstd[C]);
 		NEXTOP;
@@ -1892,6 +1844,88 @@ static void DoCast(const VMRegisters &reg, const VMFrame *f, int a, int b, int c
 //
 //===========================================================================
 
+// Stores the argument of a PARAM or PARAM_CALL instruction.
+static void DoParam(const VMRegisters &reg, VMFrame *f, const VMScriptFunction *sfunc, int a, int b)
+{
+	VMValue *param = &reg.param[f->NumParam++];
+	if (a == REGT_NIL)
+	{
+		::new(param) VMValue();
+	}
+	else
+	{
+		switch(a)
+		{
+		case REGT_INT:
+			assert(b < f->NumRegD);
+			::new(param) VMValue(reg.d[b]);
+			break;
+		case REGT_INT | REGT_ADDROF:
+			assert(b < f->NumRegD);
+			::new(param) VMValue(&reg.d[b]);
+			break;
+		case REGT_INT | REGT_KONST:
+			assert(b < sfunc->NumKonstD);
+			::new(param) VMValue(sfunc->KonstD[b]);
+			break;
+		case REGT_STRING:
+			assert(b < f->NumRegS);
+			::new(param) VMValue(&reg.s[b]);
+			break;
+		case REGT_STRING | REGT_ADDROF:
+			assert(b < f->NumRegS);
+			::new(param) VMValue((void*)&reg.s[b]);	// Note that this may not use the FString* version of the constructor!
+			break;
+		case REGT_STRING | REGT_KONST:
+			assert(b < sfunc->NumKonstS);
+			::new(param) VMValue(&sfunc->KonstS[b]);
+			break;
+		case REGT_POINTER:
+			assert(b < f->NumRegA);
+			::new(param) VMValue(reg.a[b]);
+			break;
+		case REGT_POINTER | REGT_ADDROF:
+			assert(b < f->NumRegA);
+			::new(param) VMValue(&reg.a[b]);
+			break;
+		case REGT_POINTER | REGT_KONST:
+			assert(b < sfunc->NumKonstA);
+			::new(param) VMValue(sfunc->KonstA[b].v);
+			break;
+		case REGT_FLOAT:
+			assert(b < f->NumRegF);
+			::new(param) VMValue(reg.f[b]);
+			break;
+		case REGT_FLOAT | REGT_MULTIREG2:
+			assert(b < f->NumRegF - 1);
+			assert(f->NumParam < sfunc->MaxParam);
+			::new(param) VMValue(reg.f[b]);
+			::new(param + 1) VMValue(reg.f[b + 1]);
+			f->NumParam++;
+			break;
+		case REGT_FLOAT | REGT_MULTIREG3:
+			assert(b < f->NumRegF - 2);
+			assert(f->NumParam < sfunc->MaxParam - 1);
+			::new(param) VMValue(reg.f[b]);
+			::new(param + 1) VMValue(reg.f[b + 1]);
+			::new(param + 2) VMValue(reg.f[b + 2]);
+			f->NumParam += 2;
+			break;
+		case REGT_FLOAT | REGT_ADDROF:
+			assert(b < f->NumRegF);
+			::new(param) VMValue(&reg.f[b]);
+			break;
+		case REGT_FLOAT | REGT_KONST:
+			assert(b < sfunc->NumKonstF);
+			::new(param) VMValue(sfunc->KonstF[b]);
+			break;
+		default:
+			assert(0);
+			break;
+		}
+	}
+}
+
 static void FillReturns(const VMRegisters &reg, VMFrame *frame, VMReturn *returns, const VMOP *retval, int numret)
 {
 	int i, type, regnum;
@@ -43,6 +43,14 @@
 #include "jit.h"
 #include "c_cvars.h"
 #include "version.h"
+#include "files.h"
+#include "m_misc.h"
+#include "i_time.h"
+#include "doomerrors.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #if (defined(_M_X64  ) || defined(__x86_64) || defined(__x86_64__) || defined(_M_AMD64) || defined(__amd64 ) || defined(__amd64__ ))
 #define ARCH_X64
@@ -132,6 +140,7 @@ VMScriptFunction::VMScriptFunction(FName name)
 	NumKonstA = 0;
 	MaxParam = 0;
 	NumArgs = 0;
+	PendingClass = nullptr;
 	ScriptCall = &VMScriptFunction::FirstScriptCall;
 }
 
@@ -280,12 +289,151 @@ static bool CanJit(VMScriptFunction *func)
 	return false;
 }
 
-int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+//==========================================================================
+//
+// JIT warm-up
+//
+// Functions get compiled to native code on their first call, which can
+// cause a visible hitch the first time some monster wakes up. Every
+// function compiled this way during play is remembered, and the list can
+// be saved with 'jitsavewarmup'. On the next start the listed functions
+// (or all of them, with vm_jitwarmup 2) are compiled right after the
+// scripts are loaded.
+//
+// With vm_jitbackground the compiles are done by a worker thread. The
+// function runs in the interpreter until its code is ready, and the
+// native entry point is swapped in by JitInstallBackground at the start
+// of the next tic, when no script code is running.
+//
+//==========================================================================
+
+CVAR(Int, vm_jitwarmup, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Bool, vm_jitbackground, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
+static TArray<VMScriptFunction *> HotFunctions;
+static TMap<VMScriptFunction *, bool> HotFunctionSet;
+static bool JitWarmUpActive;
+static TMap<FString, bool> JitWarmUpList;
+
+static void AddHotFunction(VMScriptFunction *func)
+{
+	if (HotFunctionSet.CheckKey(func) == nullptr)
+	{
+		HotFunctionSet[func] = true;
+		HotFunctions.Push(func);
+	}
+}
+
+static FString JitWarmUpFile()
+{
+	return M_GetCachePath(true) + "/jitwarmup.txt";
+}
+
+#ifdef ARCH_X64
+struct FJitJob
+{
+	VMScriptFunction *Func;
+	JitFuncPtr Code;
+	FString Error;
+};
+
+static std::thread JitThread;
+static std::mutex JitQueueMutex;
+static std::condition_variable JitQueueCond;
+static TArray<VMScriptFunction *> JitQueue;
+static TArray<FJitJob> JitFinished;
+static bool JitStopThread;
+
+static void JitThreadMain()
+{
+	std::unique_lock<std::mutex> lock(JitQueueMutex);
+	while (true)
+	{
+		JitQueueCond.wait(lock, []() { return JitStopThread || JitQueue.Size() > 0; });
+		if (JitStopThread)
+			break;
+
+		FJitJob job;
+		JitQueue.Pop(job.Func);
+		lock.unlock();
+		try
+		{
+			job.Code = JitCompile(job.Func, &job.Error);
+		}
+		catch (const CDoomError &err)
+		{
+			job.Code = nullptr;
+			job.Error = err.GetMessage();
+		}
+		lock.lock();
+		JitFinished.Push(job);
+	}
+}
+
+static void JitQueueBackground(VMScriptFunction *func)
+{
+	std::lock_guard<std::mutex> lock(JitQueueMutex);
+	JitQueue.Push(func);
+	if (!JitThread.joinable())
+		JitThread = std::thread(JitThreadMain);
+	JitQueueCond.notify_one();
+}
+#endif
+
+void JitInstallBackground()
+{
+#ifdef ARCH_X64
+	TArray<FJitJob> finished;
+	{
+		std::lock_guard<std::mutex> lock(JitQueueMutex);
+		if (JitFinished.Size() == 0)
+			return;
+		finished = std::move(JitFinished);
+	}
+	for (auto &job : finished)
+	{
+		if (job.Code != nullptr)
+			job.Func->ScriptCall = job.Code;
+		else
+			Printf("%s: Unexpected JIT error: %s\n", job.Func->PrintableName.GetChars(), job.Error.GetChars());
+	}
+#endif
+}
+
+void JitWarmUpRelease()
+{
+#ifdef ARCH_X64
+	if (JitThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(JitQueueMutex);
+			JitStopThread = true;
+		}
+		JitQueueCond.notify_one();
+		JitThread.join();
+		JitStopThread = false;
+	}
+	JitQueue.Clear();
+	JitFinished.Clear();
+#endif
+	HotFunctions.Clear();
+	HotFunctionSet.Clear();
+	JitWarmUpList.Clear();
+	JitWarmUpActive = false;
+}
+
+static void InstallScriptCall(VMScriptFunction *func, bool background)
 {
 #ifdef ARCH_X64
-	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
+	if (vm_jit && CanJit(func))
 	{
-		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
+		if (background && vm_jitbackground)
+		{
+			func->ScriptCall = VMExec;
+			JitQueueBackground(func);
+			return;
+		}
+		func->ScriptCall = JitCompile(func);
 		if (!func->ScriptCall)
 			func->ScriptCall = VMExec;
 	}
@@ -296,10 +444,85 @@ int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int num
 #else
 	func->ScriptCall = VMExec;
 #endif
+}
+
+int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	if (sfunc->PendingClass != nullptr) VMFinishDeferred(sfunc->PendingClass);
+	// The warm-up may have taken care of it while the class was generated.
+	if (sfunc->ScriptCall == &VMScriptFunction::FirstScriptCall) InstallScriptCall(sfunc, true);
+	if (vm_jit) AddHotFunction(sfunc);
 
 	return func->ScriptCall(func, params, numparams, ret, numret);
 }
 
+// Functions of actor classes whose code has not been generated yet are
+// left alone, that would undo the deferred code generation. They get
+// here again from FinishClass once their class has been generated.
+void JitWarmUpFunction(VMScriptFunction *func)
+{
+	if (!JitWarmUpActive || func->PendingClass != nullptr || func->ScriptCall != &VMScriptFunction::FirstScriptCall) return;
+
+	if (vm_jitwarmup == 1)
+	{
+		if (JitWarmUpList.CheckKey(func->PrintableName) == nullptr) return;
+		AddHotFunction(func);	// keep it in the list when it gets saved again
+	}
+	InstallScriptCall(func, true);
+}
+
+void JitWarmUp()
+{
+	if (!vm_jit || vm_jitwarmup <= 0) return;
+
+	if (vm_jitwarmup == 1)
+	{
+		FileReader fr;
+		if (!fr.OpenFile(JitWarmUpFile())) return;
+
+		auto buffer = fr.Read();
+		buffer.Push(0);
+		FString text = (const char *)buffer.Data();
+		for (auto &name : text.Split("\n", FString::TOK_SKIPEMPTY))
+		{
+			name.StripRight();
+			JitWarmUpList[name] = true;
+		}
+	}
+	JitWarmUpActive = true;
+
+	cycle_t timer;
+	timer.Reset();
+	timer.Clock();
+	for (auto f : VMFunction::AllFunctions)
+	{
+		if (f->ScriptCall == &VMScriptFunction::FirstScriptCall)
+		{
+			JitWarmUpFunction(static_cast<VMScriptFunction *>(f));
+		}
+	}
+	timer.Unclock();
+	DPrintf(DMSG_NOTIFY, "JIT warm-up took %.2f ms\n", timer.TimeMS());
+}
+
+CCMD(jitsavewarmup)
+{
+	FString filename = argv.argc() > 1 ? FString(argv[1]) : JitWarmUpFile();
+	FileWriter *fw = FileWriter::Open(filename);
+	if (fw == nullptr)
+	{
+		Printf("Could not write %s\n", filename.GetChars());
+		return;
+	}
+	for (auto f : HotFunctions)
+	{
+		fw->Printf("%s\n", f->PrintableName.GetChars());
+	}
+	delete fw;
+	Printf("%u functions written to %s\n", HotFunctions.Size(), filename.GetChars());
+}
+
 int VMNativeFunction::NativeScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *returns, int numret)
 {
 	try
@@ -552,7 +775,9 @@ int VMCall(VMFunction *func, VMValue *params, int numparams, VMReturn *results,
 		}
 		else
 		{
-			auto code = static_cast<VMScriptFunction *>(func)->Code;
+			auto sfunc = static_cast<VMScriptFunction *>(func);
+			if (sfunc->PendingClass != nullptr) VMFinishDeferred(sfunc->PendingClass);
+			auto code = sfunc->Code;
 			// handle empty functions consisting of a single return explicitly so that empty virtual callbacks do not need to set up an entire VM frame.
 			// code cann be null here in case of some non-fatal DECORATE errors.
 			if (code == nullptr || code->word == (0x00808000|OP_RET))
@@ -569,7 +794,6 @@ int VMCall(VMFunction *func, VMValue *params, int numparams, VMReturn *results,
 			{
 				VMCycles[0].Clock();
 
-				auto sfunc = static_cast<VMScriptFunction *>(func);
 				int numret = sfunc->ScriptCall(sfunc, params, numparams, results, numresults);
 				VMCycles[0].Unclock();
 				return numret;
@@ -765,3 +989,38 @@ CCMD(vmengine)
 	Printf("Usage: vmengine <default|checked|unchecked>\n");
 }
 
+
+//-----------------------------------------------------------------------------
+//
+// Runs the workloads in zscript/devtools/vmbench.txt through whichever
+// engine this session uses, to compare interpreter changes. They are only
+// compiled when the engine is started with -vmbench.
+//
+//-----------------------------------------------------------------------------
+EXTERN_CVAR(Bool, vm_fuseops)
+
+CCMD(vmbench)
+{
+	static const char *const tests[] = { "Arithmetic", "MemberTests", "StaticCalls", "VirtualCalls", "FloatMath" };
+
+	int count = argv.argc() > 1 ? atoi(argv[1]) : 0;
+	if (count <= 0) count = 1000000;
+
+	Printf("%s, %d iterations\n", vm_jit ? "JIT" : vm_fuseops ? "Interpreter with superinstructions" : "Interpreter", count);
+	for (auto name : tests)
+	{
+		VMFunction *func = PClass::FindFunction("VMBench", name);
+		if (func == nullptr)
+		{
+			Printf("%s: not found. Start with -vmbench to load the workloads.\n", name);
+			return;
+		}
+		VMValue param = count;
+		int result;
+		VMReturn ret(&result);
+		uint64_t start = I_nsTime();
+		VMCall(func, &param, 1, &ret, 1);
+		uint64_t ns = I_nsTime() - start;
+		Printf("%-14s %10.3f ms %8.2f ns/iteration\n", name, ns / 1e6, double(ns) / count);
+	}
+}
@@ -252,6 +252,7 @@ struct VMFrame
 	VM_UBYTE NumRegA;
 	VM_UHALF MaxParam;
 	VM_UHALF NumParam;		// current number of parameters
+	const VMOP *PC;			// instruction of the call in progress, for the sampling profiler
 
 	static int FrameSize(int numregd, int numregf, int numregs, int numrega, int numparam, int numextra)
 	{
@@ -357,6 +358,11 @@ public:
 		assert(Blocks != NULL && Blocks->LastFrame != NULL);
 		return Blocks->LastFrame;
 	}
+	// Unlike TopFrame this may be called on an empty stack. Used by the sampling profiler's signal handler.
+	VMFrame *PeekTopFrame() const
+	{
+		return Blocks != NULL ? Blocks->LastFrame : NULL;
+	}
 	static int OffsetLastFrame() { return (int)(ptrdiff_t)offsetof(BlockHeader, LastFrame); }
 private:
 	enum { BLOCK_SIZE = 4096 };		// Default block size
@@ -469,6 +475,7 @@ public:
 	VM_UHALF NumKonstA;
 	VM_UHALF MaxParam;		// Maximum number of parameters this function has on the stack at once
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
+	PClass *PendingClass;	// if set, the code has not been generated yet. See FFunctionBuildList::FinishClass.
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
 
 	void InitExtra(void *addr);
@@ -478,4 +485,6 @@ public:
 
 private:
 	static int FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
+	friend void JitWarmUp();
+	friend void JitWarmUpFunction(VMScriptFunction *func);
 };
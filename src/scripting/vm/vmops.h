@@ -257,4 +257,11 @@ xx(SUBA,		sub,	RIRPRP,		NOP,	0, 0)		// dA = pB - pC
 xx(EQA_R,		beq,	CPRR,		NOP,	0, 0)			// if ((pB == pkC) != A) then pc++
 xx(EQA_K,		beq,	CPRK,		EQA_R,	4, REGT_POINTER)
 
+// Superinstructions, only created by VMFunctionBuilder::Fuse. They are encoded like their first half and
+// run the instruction after them directly, which is left in place so that branches into it still work.
+xx(LW_EQ,		lw,		RIRPKI,		NOP,	0, 0)		// LW, then the EQ_K that follows
+xx(LBU_EQ,		lbu,	RIRPKI,		NOP,	0, 0)		// LBU, then the EQ_K that follows
+xx(LBIT_EQ,		lbit,	RIRPI8,		NOP,	0, 0)		// LBIT, then the EQ_K that follows
+xx(PARAM_CALL,	param,	__BCP,		NOP,	0, 0)		// PARAM, then the CALL_K that follows
+
 #undef xx
@@ -0,0 +1,533 @@
+//
+//---------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//--------------------------------------------------------------------------
+//
+// Sampling profiler for script code
+//
+// A helper thread interrupts the main thread at a fixed interval. The
+// signal handler only copies the native return addresses and the
+// interpreter's frame chain into a preallocated buffer; everything else
+// happens once per tic in VMProfilerTick, with the signal blocked.
+//
+// JIT frames are attributed to a function and source line through the
+// JIT's line tables. Interpreted frames know the line of the call they are
+// executing, so time spent in callees and native functions gets a line;
+// time spent in the interpreter's own opcodes only gets the function.
+//
+//--------------------------------------------------------------------------
+//
+
+#include <algorithm>
+#include "vm.h"
+#include "vmintern.h"
+#include "jit.h"
+#include "files.h"
+#include "cmdlib.h"
+#include "c_dispatch.h"
+#include "v_text.h"
+#include "templates.h"
+
+#ifndef _WIN32
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <pthread.h>
+#include <signal.h>
+#include <errno.h>
+#include <execinfo.h>
+#define HAVE_VM_PROFILER
+#endif
+
+namespace
+{
+	enum
+	{
+		MaxNativeFrames = 48,
+		MaxVMFrames = 24,
+		NumRawSamples = 8192,		// 8 seconds at the default rate before samples get dropped
+	};
+
+	struct FRawSample
+	{
+		int NumNative;
+		int NumVM;
+		void *Native[MaxNativeFrames];
+		VMFunction *VMFunc[MaxVMFrames];
+		const VMOP *VMPC[MaxVMFrames];
+	};
+
+	struct FProfFunction
+	{
+		FString Name;
+		FString File;
+		unsigned Self = 0;
+		unsigned Total = 0;
+		unsigned Stamp = 0;
+	};
+
+	struct FProfLine
+	{
+		int Func;
+		int Line;
+		unsigned Self = 0;
+		unsigned Total = 0;
+		unsigned Stamp = 0;
+	};
+
+	struct FProfFrame
+	{
+		int Func;
+		int Line;
+	};
+
+	struct FResolvedPC
+	{
+		int Func;		// -1 for native code
+		int Line;
+	};
+
+	class FVMProfiler
+	{
+	public:
+		bool IsRecording() const { return Recording; }
+
+		bool Start(int intervalus);
+		void Stop();
+		void Clear();
+		void Drain();
+
+		void PrintReport(unsigned limit);
+		bool WriteFolded(const char *filename, bool lines);
+
+	private:
+		int FindFunction(const FString &name, const FString &file);
+		int FindLine(int func, int line);
+		void AddSample(const FRawSample &raw);
+
+		bool Recording = false;
+		unsigned Serial = 0;
+		unsigned NumSamples = 0;
+		unsigned NumScriptSamples = 0;
+
+		TArray<FProfFunction> Functions;
+		TMap<FString, int> FunctionMap;
+		TArray<FProfLine> Lines;
+		TMap<uint64_t, int> LineMap;
+		TMap<void *, FResolvedPC> PCCache;
+		TMap<VMFunction *, int> VMFuncCache;
+		TMap<FString, unsigned> Folded;
+		TMap<FString, unsigned> FoldedLines;
+		TArray<FProfFrame> Frames;
+	};
+
+	FVMProfiler VMProfiler;
+
+#ifdef HAVE_VM_PROFILER
+	FRawSample *RawSamples;
+	volatile unsigned RawCount;
+	volatile unsigned RawDropped;
+	unsigned DroppedReported;
+
+	pthread_t MainThread;
+	std::thread SamplerThread;
+	std::atomic<bool> SamplerRunning;
+
+	void SampleSignal(int)
+	{
+		int savederrno = errno;
+		unsigned pos = RawCount;
+		if (pos >= (unsigned)NumRawSamples)
+		{
+			RawDropped = RawDropped + 1;
+		}
+		else
+		{
+			FRawSample &s = RawSamples[pos];
+			s.NumNative = backtrace(s.Native, MaxNativeFrames);
+
+			// The frame on top may still be in construction, so stop at the first one without a function.
+			int n = 0;
+			for (VMFrame *f = GlobalVMStack.PeekTopFrame(); f != nullptr && f->Func != nullptr && n < MaxVMFrames; f = f->ParentFrame, n++)
+			{
+				s.VMFunc[n] = f->Func;
+				s.VMPC[n] = f->PC;
+			}
+			s.NumVM = n;
+			RawCount = pos + 1;
+		}
+		errno = savederrno;
+	}
+
+	void BlockSampleSignal(bool block)
+	{
+		sigset_t set;
+		sigemptyset(&set);
+		sigaddset(&set, SIGPROF);
+		pthread_sigmask(block ? SIG_BLOCK : SIG_UNBLOCK, &set, nullptr);
+	}
+#endif
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+bool FVMProfiler::Start(int intervalus)
+{
+#ifdef HAVE_VM_PROFILER
+	if (Recording) return true;
+
+	if (RawSamples == nullptr) RawSamples = new FRawSample[NumRawSamples];
+	RawCount = 0;
+
+	// backtrace loads libgcc on its first call, which must not happen inside the handler.
+	void *dummy[1];
+	backtrace(dummy, 1);
+
+	struct sigaction act;
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = SampleSignal;
+	act.sa_flags = SA_RESTART;
+	sigemptyset(&act.sa_mask);
+	sigaction(SIGPROF, &act, nullptr);
+
+	MainThread = pthread_self();
+	SamplerRunning = true;
+	SamplerThread = std::thread([=]()
+	{
+		while (SamplerRunning)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(intervalus));
+			pthread_kill(MainThread, SIGPROF);
+		}
+	});
+	Recording = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void FVMProfiler::Stop()
+{
+#ifdef HAVE_VM_PROFILER
+	if (!Recording) return;
+
+	SamplerRunning = false;
+	SamplerThread.join();
+	signal(SIGPROF, SIG_IGN);
+	Recording = false;
+	Drain();
+#endif
+}
+
+void FVMProfiler::Clear()
+{
+	Serial = NumSamples = NumScriptSamples = 0;
+	Functions.Clear();
+	FunctionMap.Clear();
+	Lines.Clear();
+	LineMap.Clear();
+	PCCache.Clear();
+	VMFuncCache.Clear();
+	Folded.Clear();
+	FoldedLines.Clear();
+#ifdef HAVE_VM_PROFILER
+	RawDropped = DroppedReported = 0;
+#endif
+}
+
+//==========================================================================
+//
+// Called once per tic. Nothing here may run inside the handler, so the
+// signal stays blocked while the buffer is read and reset.
+//
+//==========================================================================
+
+void FVMProfiler::Drain()
+{
+#ifdef HAVE_VM_PROFILER
+	if (RawSamples == nullptr || RawCount == 0) return;
+
+	BlockSampleSignal(true);
+	for (unsigned i = 0; i < RawCount; i++)
+	{
+		AddSample(RawSamples[i]);
+	}
+	RawCount = 0;
+	BlockSampleSignal(false);
+
+	if (RawDropped != DroppedReported)
+	{
+		DroppedReported = RawDropped;
+		Printf("vmprofile: %u samples dropped so far\n", DroppedReported);
+	}
+#endif
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+int FVMProfiler::FindFunction(const FString &name, const FString &file)
+{
+	int *index = FunctionMap.CheckKey(name);
+	if (index != nullptr) return *index;
+
+	int func = Functions.Reserve(1);
+	Functions[func].Name = name;
+	Functions[func].File = file;
+	FunctionMap[name] = func;
+	return func;
+}
+
+int FVMProfiler::FindLine(int func, int line)
+{
+	uint64_t key = ((uint64_t)func << 32) | (uint32_t)line;
+	int *index = LineMap.CheckKey(key);
+	if (index != nullptr) return *index;
+
+	int l = Lines.Reserve(1);
+	Lines[l].Func = func;
+	Lines[l].Line = line;
+	LineMap[key] = l;
+	return l;
+}
+
+//==========================================================================
+//
+// JIT frames come from the native stack and take precedence, since JIT
+// functions that need a full VM frame show up in both lists. Only when
+// there are none is the interpreter's frame chain used.
+//
+//==========================================================================
+
+void FVMProfiler::AddSample(const FRawSample &raw)
+{
+	NumSamples++;
+	Frames.Clear();
+
+	for (int i = 0; i < raw.NumNative; i++)
+	{
+		FResolvedPC *res = PCCache.CheckKey(raw.Native[i]);
+		if (res == nullptr)
+		{
+			FString name, file;
+			int line;
+			res = &PCCache[raw.Native[i]];
+			if (JitPCToScriptLine(raw.Native[i], name, file, line))
+			{
+				res->Func = FindFunction(name, file);
+				res->Line = line;
+			}
+			else
+			{
+				res->Func = -1;
+				res->Line = -1;
+			}
+		}
+		if (res->Func >= 0) Frames.Push({ res->Func, res->Line });
+	}
+
+	if (Frames.Size() == 0)
+	{
+		for (int i = 0; i < raw.NumVM; i++)
+		{
+			VMFunction *vmfunc = raw.VMFunc[i];
+			auto sfunc = static_cast<VMScriptFunction *>(vmfunc);
+			int *index = VMFuncCache.CheckKey(vmfunc);
+			int func = index != nullptr ? *index : (VMFuncCache[vmfunc] = FindFunction(vmfunc->PrintableName, sfunc->SourceFileName));
+			Frames.Push({ func, raw.VMPC[i] != nullptr ? sfunc->PCToLine(raw.VMPC[i]) : -1 });
+		}
+	}
+
+	if (Frames.Size() == 0) return;
+	NumScriptSamples++;
+	Serial++;
+
+	Functions[Frames[0].Func].Self++;
+	if (Frames[0].Line >= 0) Lines[FindLine(Frames[0].Func, Frames[0].Line)].Self++;
+
+	FString stack, stacklines;
+	for (int i = Frames.Size() - 1; i >= 0; i--)
+	{
+		auto &frame = Frames[i];
+		auto &func = Functions[frame.Func];
+		if (func.Stamp != Serial)
+		{
+			func.Stamp = Serial;
+			func.Total++;
+		}
+		if (frame.Line >= 0)
+		{
+			auto &line = Lines[FindLine(frame.Func, frame.Line)];
+			if (line.Stamp != Serial)
+			{
+				line.Stamp = Serial;
+				line.Total++;
+			}
+		}
+
+		if (stack.IsNotEmpty())
+		{
+			stack += ';';
+			stacklines += ';';
+		}
+		stack += func.Name;
+		stacklines += func.Name;
+		if (frame.Line >= 0) stacklines.AppendFormat(":%d", frame.Line);
+	}
+	Folded[stack]++;
+	FoldedLines[stacklines]++;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void FVMProfiler::PrintReport(unsigned limit)
+{
+	Drain();
+	if (NumScriptSamples == 0)
+	{
+		Printf("No script samples recorded\n");
+		return;
+	}
+	if (limit == 0) limit = 20;
+
+	Printf("%u samples, %u in script code (%.1f%%)%s\n", NumSamples, NumScriptSamples,
+		NumScriptSamples * 100. / NumSamples, Recording ? " (still recording)" : "");
+
+	TArray<int> sorted;
+	for (unsigned i = 0; i < Functions.Size(); i++) sorted.Push(i);
+	std::sort(sorted.begin(), sorted.end(), [&](int a, int b) { return Functions[a].Self > Functions[b].Self; });
+
+	Printf(TEXTCOLOR_YELLOW "\nSelf, %%    Total, %%   Function\n");
+	Printf(TEXTCOLOR_YELLOW "--------  ---------  --------------------\n");
+	for (unsigned i = 0; i < MIN(limit, sorted.Size()); i++)
+	{
+		auto &f = Functions[sorted[i]];
+		Printf("%8.2f  %9.2f  %s\n", f.Self * 100. / NumSamples, f.Total * 100. / NumSamples, f.Name.GetChars());
+	}
+
+	sorted.Clear();
+	for (unsigned i = 0; i < Lines.Size(); i++) sorted.Push(i);
+	std::sort(sorted.begin(), sorted.end(), [&](int a, int b) { return Lines[a].Self > Lines[b].Self; });
+
+	Printf(TEXTCOLOR_YELLOW "\nSelf, %%    Total, %%   Line\n");
+	Printf(TEXTCOLOR_YELLOW "--------  ---------  --------------------\n");
+	for (unsigned i = 0; i < MIN(limit, sorted.Size()); i++)
+	{
+		auto &l = Lines[sorted[i]];
+		auto &f = Functions[l.Func];
+		Printf("%8.2f  %9.2f  %s:%d (%s)\n", l.Self * 100. / NumSamples, l.Total * 100. / NumSamples, f.File.GetChars(), l.Line, f.Name.GetChars());
+	}
+}
+
+//==========================================================================
+//
+// One line per distinct stack, root first, as read by flamegraph.pl,
+// speedscope and similar tools.
+//
+//==========================================================================
+
+bool FVMProfiler::WriteFolded(const char *filename, bool lines)
+{
+	Drain();
+
+	FileWriter *fw = FileWriter::Open(filename);
+	if (fw == nullptr) return false;
+
+	TMap<FString, unsigned>::Iterator it(lines ? FoldedLines : Folded);
+	TMap<FString, unsigned>::Pair *pair;
+	while (it.NextPair(pair))
+	{
+		fw->Printf("%s %u\n", pair->Key.GetChars(), pair->Value);
+	}
+	delete fw;
+	return true;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void VMProfilerTick()
+{
+	if (VMProfiler.IsRecording()) VMProfiler.Drain();
+}
+
+CCMD(vmprofile)
+{
+	const char *cmd = argv.argc() > 1 ? argv[1] : "";
+
+	if (!stricmp(cmd, "start"))
+	{
+		int interval = argv.argc() > 2 ? atoi(argv[2]) : 1000;
+		VMProfiler.Clear();
+		if (VMProfiler.Start(clamp(interval, 100, 100000)))
+		{
+			Printf("Script profile started\n");
+		}
+		else
+		{
+			Printf("Script profiling is not supported on this platform\n");
+		}
+	}
+	else if (!stricmp(cmd, "stop"))
+	{
+		VMProfiler.Stop();
+		Printf("Script profile stopped\n");
+	}
+	else if (!stricmp(cmd, "clear"))
+	{
+		VMProfiler.Clear();
+	}
+	else if (!stricmp(cmd, "report"))
+	{
+		VMProfiler.PrintReport(argv.argc() > 2 ? atoi(argv[2]) : 0);
+	}
+	else if (!stricmp(cmd, "dump") && argv.argc() > 2)
+	{
+		FString filename = argv[2];
+		DefaultExtension(filename, ".folded");
+		if (VMProfiler.WriteFolded(filename, argv.argc() > 3 && !stricmp(argv[3], "lines")))
+		{
+			Printf("Script profile written to %s\n", filename.GetChars());
+		}
+		else
+		{
+			Printf("Could not write %s\n", filename.GetChars());
+		}
+	}
+	else
+	{
+		Printf(
+			"Usage: vmprofile start [interval in microseconds]\n"
+			"       vmprofile stop|clear\n"
+			"       vmprofile report [limit]\n"
+			"       vmprofile dump <file> [lines]\n");
+	}
+}
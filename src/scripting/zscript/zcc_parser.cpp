@@ -36,8 +36,12 @@
 #include "w_wad.h"
 #include "cmdlib.h"
 #include "m_argv.h"
+#include "stats.h"
 #include "v_text.h"
 #include "version.h"
+#include "md5.h"
+#include "m_misc.h"
+#include "c_cvars.h"
 #include "zcc_parser.h"
 #include "zcc_compile.h"
 
@@ -231,6 +235,278 @@ static void InitTokenMap()
 #undef TOKENDEF
 #undef TOKENDEF2
 
+//**--------------------------------------------------------------------------
+//
+// Token cache
+//
+// Lexing a script lump only depends on its contents, so the token stream of
+// every lump that parsed without errors can be stored in the cache directory.
+// There is one entry per lump, so an edited lump replaces its old entry
+// instead of adding a new one. The entry holds the MD5 of the text it was
+// made from and is only used if that still matches. The tokens are fed to
+// the grammar straight from the cache, so the AST that comes out is the same
+// as from a full scan.
+//
+// This only saves the scanner's work, not the parser's or the compiler's, so
+// it is off by default. clearnodecache removes the entries along with the
+// rest of the cache directory.
+//
+//**--------------------------------------------------------------------------
+
+CVAR(Bool, zscript_cachetokens, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+
+class FZScriptTokenCache
+{
+	enum
+	{
+		TVK_Value,		// Int or Float are stored as they are
+		TVK_String,
+		TVK_Name,		// name indices are only valid for the current run so the text is stored
+	};
+
+	enum
+	{
+		FORMAT_VERSION = 2
+	};
+
+	struct FToken
+	{
+		int TokenType;
+		int SourceLoc;
+		int ScanLine;	// the scanner's line when the token was passed on, for the grammar's own line queries
+		int Kind;
+		union
+		{
+			int Int;
+			double Float;
+			unsigned TextOfs;
+		};
+		unsigned TextLen;
+	};
+
+	TArray<FToken> Tokens;
+	TArray<char> Text;
+	int EndLine = 0;
+	uint8_t Digest[16];
+	FString Path;
+
+	// The file is written field by field in little endian order, so it does not depend on the compiler's struct layout.
+	static void WriteInt(TArray<uint8_t> &out, uint32_t v)
+	{
+		uint8_t b[] = { uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24) };
+		WriteBytes(out, b, 4);
+	}
+
+	static void WriteBytes(TArray<uint8_t> &out, const void *data, unsigned len)
+	{
+		if (len > 0) memcpy(&out[out.Reserve(len)], data, len);
+	}
+
+	static bool ReadInt(const TArray<uint8_t> &in, unsigned &pos, uint32_t &v)
+	{
+		if (in.Size() - pos < 4) return false;
+		v = in[pos] | (in[pos + 1] << 8) | (in[pos + 2] << 16) | (uint32_t(in[pos + 3]) << 24);
+		pos += 4;
+		return true;
+	}
+
+public:
+	FZScriptTokenCache(int lump, const FString &script, bool mainfile, VersionInfo version)
+	{
+		if (!zscript_cachetokens || lump < 0) return;
+
+		// The main file's tokens start after its version directive, so those two cases must not share an entry.
+		FString key;
+		key.Format("%s|%d|%d.%d.%d", Wads.GetLumpFullPath(lump).GetChars(), mainfile, version.major, version.minor, version.revision);
+
+		MD5Context md5;
+		uint8_t keydigest[16];
+		md5.Update((const uint8_t *)key.GetChars(), (unsigned)key.Len());
+		md5.Final(keydigest);
+
+		// This hashes the scanner's copy of the lump, so the lump does not need to be read a second time.
+		md5.Init();
+		md5.Update((const uint8_t *)script.GetChars(), (unsigned)script.Len());
+		md5.Final(Digest);
+
+		Path = "zscript/";
+		for (auto b : keydigest) Path.AppendFormat("%02x", b);
+		Path << ".ztc";
+	}
+
+	bool IsEnabled() const
+	{
+		return Path.IsNotEmpty();
+	}
+
+	void Record(int tokentype, const ZCCToken &value, int scanline, int kind = TVK_Value, const char *text = nullptr, int textlen = 0)
+	{
+		FToken &tok = Tokens[Tokens.Reserve(1)];
+		tok.TokenType = tokentype;
+		tok.SourceLoc = value.SourceLoc;
+		tok.ScanLine = scanline;
+		tok.Kind = kind;
+		tok.TextLen = textlen;
+		if (kind == TVK_Value)
+		{
+			tok.Float = 0;
+			if (tokentype == ZCC_FLOATCONST) tok.Float = value.Float;
+			else tok.Int = value.Int;
+		}
+		else
+		{
+			tok.TextOfs = Text.Reserve(textlen + 1);
+			memcpy(&Text[tok.TextOfs], text, textlen);
+			Text[tok.TextOfs + textlen] = 0;
+		}
+	}
+
+	void RecordString(int tokentype, const ZCCToken &value, int scanline, const char *text, int textlen)
+	{
+		Record(tokentype, value, scanline, TVK_String, text, textlen);
+	}
+
+	void RecordName(int tokentype, const ZCCToken &value, int scanline, const char *text)
+	{
+		Record(tokentype, value, scanline, TVK_Name, text, (int)strlen(text));
+	}
+
+	bool Load()
+	{
+		if (!IsEnabled()) return false;
+
+		FileReader fr;
+		if (!fr.OpenFile(M_GetCachePath(false) + "/" + Path)) return false;
+		TArray<uint8_t> data;
+		data.Resize((unsigned)fr.GetLength());
+		if (fr.Read(data.Data(), data.Size()) != (long)data.Size()) return false;
+
+		// header: magic, format version, build, MD5 of the script text, token count, end line
+		unsigned pos = 0;
+		uint32_t version, taglen, numtokens, endline;
+		const char *tag = GetGitHash();
+		if (data.Size() < 4 || memcmp(data.Data(), "ZTOK", 4)) return false;
+		pos = 4;
+		if (!ReadInt(data, pos, version) || version != FORMAT_VERSION) return false;
+		if (!ReadInt(data, pos, taglen) || taglen != strlen(tag) || data.Size() - pos < taglen || memcmp(&data[pos], tag, taglen)) return false;
+		pos += taglen;
+		if (data.Size() - pos < sizeof(Digest) || memcmp(&data[pos], Digest, sizeof(Digest))) return false;
+		pos += sizeof(Digest);
+		if (!ReadInt(data, pos, numtokens) || !ReadInt(data, pos, endline)) return false;
+
+		Tokens.Clear();
+		Text.Clear();
+		for (uint32_t i = 0; i < numtokens; i++)
+		{
+			FToken &tok = Tokens[Tokens.Reserve(1)];
+			uint32_t type, loc, line, kind, lo, hi;
+			if (!ReadInt(data, pos, type) || !ReadInt(data, pos, loc) || !ReadInt(data, pos, line) || !ReadInt(data, pos, kind)) return false;
+			tok.TokenType = type;
+			tok.SourceLoc = loc;
+			tok.ScanLine = line;
+			tok.Kind = kind;
+			tok.TextLen = 0;
+			if (kind == TVK_Value)
+			{
+				if (!ReadInt(data, pos, lo)) return false;
+				if (tok.TokenType == ZCC_FLOATCONST)
+				{
+					if (!ReadInt(data, pos, hi)) return false;
+					uint64_t bits = lo | (uint64_t(hi) << 32);
+					memcpy(&tok.Float, &bits, sizeof(double));
+				}
+				else tok.Int = lo;
+			}
+			else if (kind == TVK_String || kind == TVK_Name)
+			{
+				if (!ReadInt(data, pos, tok.TextLen) || data.Size() - pos < tok.TextLen) return false;
+				tok.TextOfs = Text.Reserve(tok.TextLen + 1);
+				memcpy(&Text[tok.TextOfs], &data[pos], tok.TextLen);
+				Text[tok.TextOfs + tok.TextLen] = 0;
+				pos += tok.TextLen;
+			}
+			else return false;
+		}
+		EndLine = endline;
+		return true;
+	}
+
+	void Save(int endline)
+	{
+		const char *tag = GetGitHash();
+		TArray<uint8_t> data;
+		WriteBytes(data, "ZTOK", 4);
+		WriteInt(data, FORMAT_VERSION);
+		WriteInt(data, (uint32_t)strlen(tag));
+		WriteBytes(data, tag, (unsigned)strlen(tag));
+		WriteBytes(data, Digest, sizeof(Digest));
+		WriteInt(data, Tokens.Size());
+		WriteInt(data, endline);
+		for (auto &tok : Tokens)
+		{
+			WriteInt(data, tok.TokenType);
+			WriteInt(data, tok.SourceLoc);
+			WriteInt(data, tok.ScanLine);
+			WriteInt(data, tok.Kind);
+			if (tok.Kind == TVK_Value)
+			{
+				if (tok.TokenType == ZCC_FLOATCONST)
+				{
+					uint64_t bits;
+					memcpy(&bits, &tok.Float, sizeof(double));
+					WriteInt(data, uint32_t(bits));
+					WriteInt(data, uint32_t(bits >> 32));
+				}
+				else WriteInt(data, tok.Int);
+			}
+			else
+			{
+				WriteInt(data, tok.TextLen);
+				WriteBytes(data, &Text[tok.TextOfs], tok.TextLen);
+			}
+		}
+
+		FString path = M_GetCachePath(true) + "/zscript";
+		CreatePath(path);
+		path << Path.Mid(7);
+
+		FileWriter *fw = FileWriter::Open(path);
+		if (fw != nullptr)
+		{
+			fw->Write(data.Data(), data.Size());
+			delete fw;
+		}
+	}
+
+	// Feeds the cached tokens to the parser. 'value' is left at the last token like the scanning loop does.
+	void Replay(void *parser, ZCCParseState &state, FScanner &sc, ZCCToken &value)
+	{
+		for (auto &tok : Tokens)
+		{
+			value.Largest = 0;
+			value.SourceLoc = tok.SourceLoc;
+			switch (tok.Kind)
+			{
+			case TVK_String:
+				value.String = state.Strings.Alloc(&Text[tok.TextOfs], tok.TextLen);
+				break;
+
+			case TVK_Name:
+				value.Int = FName(&Text[tok.TextOfs]).GetIndex();
+				break;
+
+			default:
+				if (tok.TokenType == ZCC_FLOATCONST) value.Float = tok.Float;
+				else value.Int = tok.Int;
+				break;
+			}
+			sc.Line = tok.ScanLine;
+			ZCCParse(parser, tok.TokenType, value, &state);
+		}
+		sc.Line = EndLine;
+	}
+};
+
 //**--------------------------------------------------------------------------
 
 static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void *parser, ZCCParseState &state)
@@ -263,6 +539,17 @@ static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void
 	sc.SetParseVersion(state.ParseVersion);
 	state.sc = &sc;
 
+	FZScriptTokenCache cache(lump, sc.GetScriptBuffer(), pSC != &lsc, state.ParseVersion);
+	int errors = FScriptPosition::ErrorCounter;
+	bool recording = false;
+
+	if (cache.Load())
+	{
+		cache.Replay(parser, state, sc, value);
+		goto parse_end;
+	}
+	recording = cache.IsEnabled();
+
 	while (sc.GetToken())
 	{
 		value.Largest = 0;
@@ -272,37 +559,44 @@ static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void
 		case TK_StringConst:
 			value.String = state.Strings.Alloc(sc.String, sc.StringLen);
 			tokentype = ZCC_STRCONST;
+			if (recording) cache.RecordString(tokentype, value, sc.GetMessageLine(), sc.String, sc.StringLen);
 			break;
 
 		case TK_NameConst:
 			value.Int = FName(sc.String).GetIndex();
 			tokentype = ZCC_NAMECONST;
+			if (recording) cache.RecordName(tokentype, value, sc.GetMessageLine(), sc.String);
 			break;
 
 		case TK_IntConst:
 			value.Int = sc.Number;
 			tokentype = ZCC_INTCONST;
+			if (recording) cache.Record(tokentype, value, sc.GetMessageLine());
 			break;
 
 		case TK_UIntConst:
 			value.Int = sc.Number;
 			tokentype = ZCC_UINTCONST;
+			if (recording) cache.Record(tokentype, value, sc.GetMessageLine());
 			break;
 
 		case TK_FloatConst:
 			value.Float = sc.Float;
 			tokentype = ZCC_FLOATCONST;
+			if (recording) cache.Record(tokentype, value, sc.GetMessageLine());
 			break;
 
 		case TK_None:	// 'NONE' is a token for SBARINFO but not here.
 		case TK_Identifier:
 			value.Int = FName(sc.String);
 			tokentype = ZCC_IDENTIFIER;
+			if (recording) cache.RecordName(tokentype, value, sc.GetMessageLine(), sc.String);
 			break;
 
 		case TK_NonWhitespace:
 			value.Int = FName(sc.String);
 			tokentype = ZCC_NWS;
+			if (recording) cache.RecordName(tokentype, value, sc.GetMessageLine(), sc.String);
 			break;
 
 		case TK_Static:
@@ -322,6 +616,7 @@ static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void
 				value.Int = NAME_Static;
 				sc.UnGet();
 			}
+			if (recording) cache.Record(tokentype, value, sc.GetMessageLine());
 			break;
 
 		default:
@@ -330,10 +625,13 @@ static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void
 			{
 				tokentype = zcctoken->TokenType;
 				value.Int = zcctoken->TokenName;
+				// Keywords carry predefined names, which have the same index in every run of the same build.
+				if (recording) cache.Record(tokentype, value, sc.GetMessageLine());
 			}
 			else
 			{
 				sc.ScriptMessage("Unexpected token %s.\n", sc.TokenName(sc.TokenType).GetChars());
+				recording = false;
 				goto parse_end;
 			}
 			break;
@@ -343,6 +641,10 @@ static void ParseSingleFile(FScanner *pSC, const char *filename, int lump, void
 parse_end:
 	value.Int = -1;
 	ZCCParse(parser, ZCC_EOF, value, &state);
+	if (recording && FScriptPosition::ErrorCounter == errors)
+	{
+		cache.Save(sc.GetMessageLine());
+	}
 	state.sc = nullptr;
 }
 
@@ -359,6 +661,11 @@ static void DoParse(int lumpnum)
 	parser = ZCCParseAlloc(malloc);
 	ZCCParseState state;
 
+	cycle_t parsetime, compiletime;
+	parsetime.Reset();
+	compiletime.Reset();
+	parsetime.Clock();
+
 #ifndef NDEBUG
 	FILE *f = nullptr;
 	const char *tracefile = Args->CheckValue("-tracefile");
@@ -440,6 +747,7 @@ static void DoParse(int lumpnum)
 	value.SourceLoc = sc.GetMessageLine();
 	ZCCParse(parser, 0, value, &state);
 	ZCCParseFree(parser, free);
+	parsetime.Unclock();
 
 	// If the parser fails, there is no point starting the compiler, because it'd only flood the output with endless errors.
 	if (FScriptPosition::ErrorCounter > 0)
@@ -471,8 +779,15 @@ static void DoParse(int lumpnum)
 
 	PSymbolTable symtable;
 	auto newns = Wads.GetLumpFile(baselump) == 0 ? Namespaces.GlobalNamespace : Namespaces.NewNamespace(Wads.GetLumpFile(baselump));
+	compiletime.Clock();
 	ZCCCompiler cc(state, NULL, symtable, newns, baselump, state.ParseVersion);
 	cc.Compile();
+	compiletime.Unclock();
+
+	if (Args->CheckParm("-scripttimes"))
+	{
+		Printf("%s: parse %.2f ms, compile %.2f ms\n", Wads.GetLumpFullPath(baselump).GetChars(), parsetime.TimeMS(), compiletime.TimeMS());
+	}
 
 	if (FScriptPosition::ErrorCounter > 0)
 	{
@@ -499,6 +814,13 @@ void ParseScripts()
 	while ((lump = Wads.FindLump("ZSCRIPT", &lastlump)) != -1)
 	{
 		DoParse(lump);
+		if (Wads.GetLumpFile(lump) == 0 && Args->CheckParm("-vmbench"))
+		{
+			// The workloads for the 'vmbench' command are only wanted when testing the VM,
+			// so that their class names do not get in the way of mods otherwise.
+			int benchlump = Wads.CheckNumForFullName("zscript/devtools/vmbench.txt", 0);
+			if (benchlump != -1) DoParse(benchlump);
+		}
 	}
 }
 
@@ -228,7 +228,7 @@ void I_InitSound ()
 	nosfx = !!Args->CheckParm ("-nosfx");
 
 	GSnd = NULL;
-	if (nosound || batchrun)
+	if (nosound || batchrun || benchrun)
 	{
 		GSnd = new NullSoundRenderer;
 		I_InitMusic ();
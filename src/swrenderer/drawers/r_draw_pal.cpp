@@ -201,6 +201,89 @@ namespace swrenderer
 		}
 	}
 
+	void DrawWall4PalCommand::Execute(DrawerThread *thread)
+	{
+		int count = batch.count;
+		int bits = batch.fracbits;
+
+		const uint8_t *source[WallColumnBatch::MaxColumns];
+		const uint8_t *colormap[WallColumnBatch::MaxColumns];
+		uint32_t frac[WallColumnBatch::MaxColumns];
+		uint32_t fracstep[WallColumnBatch::MaxColumns];
+		int y1[WallColumnBatch::MaxColumns];
+		int y2[WallColumnBatch::MaxColumns];
+
+		// Rows touched by any column and the rows covered by all of them
+		int ystart = INT_MAX, yend = INT_MIN;
+		int innerstart = INT_MIN, innerend = INT_MAX;
+		for (int i = 0; i < count; i++)
+		{
+			const WallColumnBatch::Column &column = batch.columns[i];
+			y1[i] = column.y1;
+			y2[i] = column.y2;
+			ystart = MIN(ystart, y1[i]);
+			yend = MAX(yend, y2[i]);
+			innerstart = MAX(innerstart, y1[i]);
+			innerend = MIN(innerend, y2[i]);
+		}
+		if (count != WallColumnBatch::MaxColumns)
+			innerend = innerstart;
+		yend = MIN(yend, thread->numa_end_y);
+		innerend = MIN(innerend, yend);
+
+		int y = ystart + thread->skipped_by_thread(ystart);
+		if (y >= yend)
+			return;
+
+		int num_cores = thread->num_cores;
+		for (int i = 0; i < count; i++)
+		{
+			const WallColumnBatch::Column &column = batch.columns[i];
+			source[i] = column.source;
+			colormap[i] = column.colormap;
+			frac[i] = column.texturefrac + column.iscale * (uint32_t)(y - y1[i]);
+			fracstep[i] = column.iscale * num_cores;
+		}
+
+		uint8_t *dest = batch.dest + y * batch.pitch;
+		int pitch = batch.pitch * num_cores;
+
+		while (y < yend)
+		{
+			if (y >= innerstart && y < innerend)
+			{
+				// All four columns cover this row and the ones until innerend
+				do
+				{
+					uint8_t pixels[4];
+					pixels[0] = colormap[0][source[0][frac[0] >> bits]];
+					pixels[1] = colormap[1][source[1][frac[1] >> bits]];
+					pixels[2] = colormap[2][source[2][frac[2] >> bits]];
+					pixels[3] = colormap[3][source[3][frac[3] >> bits]];
+					memcpy(dest, pixels, 4);
+
+					frac[0] += fracstep[0];
+					frac[1] += fracstep[1];
+					frac[2] += fracstep[2];
+					frac[3] += fracstep[3];
+					dest += pitch;
+					y += num_cores;
+				} while (y < innerend);
+			}
+			else
+			{
+				for (int i = 0; i < count; i++)
+				{
+					if (y >= y1[i] && y < y2[i])
+						dest[i] = colormap[i][source[i][frac[i] >> bits]];
+					frac[i] += fracstep[i];
+				}
+				dest += pitch;
+				y += num_cores;
+			}
+		}
+	}
+
 	void DrawWallMasked1PalCommand::Execute(DrawerThread *thread)
 	{
 		uint32_t fracstep = args.TextureVStep();
@@ -29,6 +29,16 @@ namespace swrenderer
 	class DrawWallSubClamp1PalCommand : public PalWall1Command { public: using PalWall1Command::PalWall1Command; void Execute(DrawerThread *thread) override; };
 	class DrawWallRevSubClamp1PalCommand : public PalWall1Command { public: using PalWall1Command::PalWall1Command; void Execute(DrawerThread *thread) override; };
 
+	class DrawWall4PalCommand : public DrawerCommand
+	{
+	public:
+		DrawWall4PalCommand(const WallColumnBatch &batch) : batch(batch) { }
+		void Execute(DrawerThread *thread) override;
+
+	private:
+		WallColumnBatch batch;
+	};
+
 	class PalSkyCommand : public DrawerCommand
 	{
 	public:
@@ -58,12 +58,17 @@
 #include "r_draw_wall32_sse2.h"
 #include "r_draw_sprite32_sse2.h"
 #include "r_draw_span32_sse2.h"
+#include "r_draw_span32_avx2.h"
 #include "r_draw_sky32_sse2.h"
 #endif
 
 #include "gi.h"
 #include "stats.h"
 #include "x86.h"
+#include "i_time.h"
+#include "c_dispatch.h"
+#include "v_text.h"
+#include "swrenderer/r_swcolormaps.h"
 #include <vector>
 
 // Use linear filtering when scaling up
@@ -78,8 +83,22 @@ CVAR(Bool, r_mipmap, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 // Level of detail texture bias
 CVAR(Float, r_lod_bias, -1.5, 0); // To do: add CVAR_ARCHIVE | CVAR_GLOBALCONFIG when a good default has been decided
 
+// Use the AVX2 span drawers on CPUs that support them
+CVAR(Bool, r_avx2drawers, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+
 namespace swrenderer
 {
+	template<typename BlendT>
+	static void PushSpan(const DrawerCommandQueuePtr &queue, const SpanDrawerArgs &args)
+	{
+#ifndef NO_SSE
+		if (CPU.bAVX2 && r_avx2drawers)
+			queue->Push<DrawSpan32AVX2T<BlendT>>(args);
+		else
+#endif
+			queue->Push<DrawSpan32T<BlendT>>(args);
+	}
+
 	void SWTruecolorDrawers::DrawWallColumn(const WallDrawerArgs &args)
 	{
 		Queue->Push<DrawWall32Command>(args);
@@ -211,32 +230,32 @@ namespace swrenderer
 
 	void SWTruecolorDrawers::DrawSpan(const SpanDrawerArgs &args)
 	{
-		Queue->Push<DrawSpan32Command>(args);
+		PushSpan<DrawSpan32TModes::OpaqueSpan>(Queue, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMasked(const SpanDrawerArgs &args)
 	{
-		Queue->Push<DrawSpanMasked32Command>(args);
+		PushSpan<DrawSpan32TModes::MaskedSpan>(Queue, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanTranslucent(const SpanDrawerArgs &args)
 	{
-		Queue->Push<DrawSpanTranslucent32Command>(args);
+		PushSpan<DrawSpan32TModes::TranslucentSpan>(Queue, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMaskedTranslucent(const SpanDrawerArgs &args)
 	{
-		Queue->Push<DrawSpanAddClamp32Command>(args);
+		PushSpan<DrawSpan32TModes::AddClampSpan>(Queue, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanAddClamp(const SpanDrawerArgs &args)
 	{
-		Queue->Push<DrawSpanTranslucent32Command>(args);
+		PushSpan<DrawSpan32TModes::TranslucentSpan>(Queue, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSpanMaskedAddClamp(const SpanDrawerArgs &args)
 	{
-		Queue->Push<DrawSpanAddClamp32Command>(args);
+		PushSpan<DrawSpan32TModes::AddClampSpan>(Queue, args);
 	}
 	
 	void SWTruecolorDrawers::DrawSingleSkyColumn(const SkyDrawerArgs &args)
@@ -931,4 +950,140 @@ namespace swrenderer
 			}
 		}
 	}
+
+	/////////////////////////////////////////////////////////////////////////////
+
+#ifndef NO_SSE
+	template<typename CommandT>
+	static double BenchSpans(SpanDrawerArgs &args, RenderViewport *viewport, DrawerThread *thread, int height, int frames)
+	{
+		uint64_t start = I_nsTime();
+		for (int frame = 0; frame < frames; frame++)
+		{
+			for (int y = 0; y < height; y++)
+			{
+				args.SetDestY(viewport, y);
+				args.SetTextureUPos(y / 512.0);
+				CommandT command(args);
+				command.Execute(thread);
+			}
+		}
+		return (I_nsTime() - start) / 1e6 / frames;
+	}
+
+	template<typename BlendT>
+	static void BenchSpanMode(const char *name, SpanDrawerArgs &args, RenderViewport *viewport, DrawerThread *thread, int height, int frames)
+	{
+		double sse2 = BenchSpans<DrawSpan32T<BlendT>>(args, viewport, thread, height, frames);
+		if (CPU.bAVX2)
+		{
+			double avx2 = BenchSpans<DrawSpan32AVX2T<BlendT>>(args, viewport, thread, height, frames);
+			Printf("%-24s %9.3f %9.3f %7.2fx\n", name, sse2, avx2, sse2 / avx2);
+		}
+		else
+		{
+			Printf("%-24s %9.3f\n", name, sse2);
+		}
+	}
+#endif
+}
+
+//==========================================================================
+//
+// Times the truecolor span drawers on a 4K target, with the SSE2 and,
+// if the CPU has it, the AVX2 code. Results are ms per full screen.
+//
+//==========================================================================
+
+CCMD(drawerbench)
+{
+#ifdef NO_SSE
+	Printf("The SIMD drawers are not available in this build\n");
+#else
+	using namespace swrenderer;
+	using namespace DrawSpan32TModes;
+
+	const int width = 3840;
+	const int height = 2160;
+	int frames = argv.argc() > 1 ? MAX(atoi(argv[1]), 1) : 10;
+
+	// GetDest adds the view window offset
+	DCanvas canvas(width + viewwindowx, height + viewwindowy, true);
+	RenderViewport viewport;
+	viewport.RenderTarget = &canvas;
+	auto thread = std::make_unique<DrawerThread>();
+
+	TArray<uint32_t> flat(64 * 64, true);
+	TArray<uint32_t> wall(256 * 256, true);
+	uint32_t seed = 1;
+	for (auto &texel : flat) texel = ((seed = seed * 1664525 + 1013904223) >> 8) | 0xff000000;
+	for (auto &texel : wall) texel = ((seed = seed * 1664525 + 1013904223) >> 8) | 0xff000000;
+	for (unsigned i = 0; i < wall.Size(); i += 7) wall[i] = 0;	// some holes for the masked drawer
+
+	FSWColormap tinted;
+	tinted.Maps = realcolormaps.Maps;
+	tinted.Color = PalEntry(255, 255, 200, 160);
+	tinted.Fade = PalEntry(255, 40, 40, 60);
+	tinted.Desaturate = 96;
+
+	DrawerLight lights[4];
+	for (int i = 0; i < 4; i++)
+	{
+		lights[i].color = 0xff4080c0;
+		lights[i].x = 300.0f * i;
+		lights[i].y = 10000.0f;
+		lights[i].z = 0.0f;
+		lights[i].radius = 1.0f / 500.0f;
+	}
+
+	SpanDrawerArgs args;
+	args.SetDestX1(0);
+	args.SetDestX2(width - 1);
+	args.SetTextureVPos(0.0);
+	args.SetTextureUStep(1.0 / 256.0);
+	args.SetTextureVStep(1.0 / 300.0);
+	args.dc_normal.Zero();
+	args.dc_viewpos.Zero();
+	args.dc_viewpos_step = { 1.0f, 0.0f, 0.0f };
+
+	auto setup = [&](const uint32_t *texels, int size, double lod, fixed_t alpha, bool additive, FSWColormap *colormap)
+	{
+		args.SetStyle(false, additive, alpha, &NormalLight);
+		args.SetBaseColormap(colormap);
+		args.SetLight(1.0f, 8 << FRACBITS);
+		args.SetTexture(texels, size, size);
+		args.SetTextureLOD(lod);
+		args.dc_lights = nullptr;
+		args.dc_num_lights = 0;
+	};
+
+	Printf("%dx%d, %d frames\n", width, height, frames);
+	Printf(TEXTCOLOR_YELLOW "%-24s %9s %9s\n", "ms per frame", "SSE2", CPU.bAVX2 ? "AVX2" : "");
+
+	setup(flat.Data(), 64, -1.0, OPAQUE, false, &NormalLight);
+	BenchSpanMode<OpaqueSpan>("flat, nearest", args, &viewport, thread.get(), height, frames);
+
+	setup(wall.Data(), 256, -1.0, OPAQUE, false, &NormalLight);
+	BenchSpanMode<OpaqueSpan>("texture, nearest", args, &viewport, thread.get(), height, frames);
+
+	setup(wall.Data(), 256, 0.5, OPAQUE, false, &NormalLight);
+	BenchSpanMode<OpaqueSpan>("texture, linear", args, &viewport, thread.get(), height, frames);
+
+	setup(flat.Data(), 64, -1.0, OPAQUE, false, &tinted);
+	BenchSpanMode<OpaqueSpan>("flat, colored light", args, &viewport, thread.get(), height, frames);
+
+	setup(flat.Data(), 64, -1.0, OPAQUE, false, &NormalLight);
+	args.dc_lights = lights;
+	args.dc_num_lights = 4;
+	BenchSpanMode<OpaqueSpan>("flat, 4 dynamic lights", args, &viewport, thread.get(), height, frames);
+
+	setup(wall.Data(), 256, -1.0, OPAQUE, false, &NormalLight);
+	BenchSpanMode<MaskedSpan>("masked", args, &viewport, thread.get(), height, frames);
+
+	setup(flat.Data(), 64, -1.0, FRACUNIT / 2, false, &NormalLight);
+	BenchSpanMode<TranslucentSpan>("translucent", args, &viewport, thread.get(), height, frames);
+
+	setup(flat.Data(), 64, -1.0, FRACUNIT / 2, true, &NormalLight);
+	BenchSpanMode<AddClampSpan>("additive", args, &viewport, thread.get(), height, frames);
+#endif
 }
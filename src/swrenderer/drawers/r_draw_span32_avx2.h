@@ -0,0 +1,409 @@
+//
+//---------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//--------------------------------------------------------------------------
+//
+
+#pragma once
+
+#include <immintrin.h>
+#include "swrenderer/drawers/r_draw_span32_sse2.h"
+
+// The AVX2 code is compiled for that target function by function, so the rest of
+// the binary still runs on older CPUs. Only use these drawers if CPU.bAVX2 is set.
+#ifndef AVX2_TARGET
+#if defined(__GNUC__) && !defined(__AVX2__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+#endif
+
+namespace swrenderer
+{
+	// Same output as DrawSpan32T, eight pixels at a time
+	template<typename BlendT>
+	class DrawSpan32AVX2T : public DrawSpan32T<BlendT>
+	{
+		typedef DrawSpan32T<BlendT> Super;
+		typedef typename Super::TextureData TextureData;
+
+	public:
+		DrawSpan32AVX2T(const SpanDrawerArgs &drawerargs) : Super(drawerargs) { }
+
+		AVX2_TARGET void Execute(DrawerThread *thread) override
+		{
+			using namespace DrawSpan32TModes;
+
+			if (thread->line_skipped_by_thread(this->args.DestY())) return;
+
+			TextureData texdata;
+			bool is_nearest_filter, is_64x64;
+			this->SetupTexture(texdata, is_nearest_filter, is_64x64);
+
+			auto shade_constants = this->args.ColormapConstants();
+			if (shade_constants.simple_shade)
+			{
+				if (is_nearest_filter)
+				{
+					if (is_64x64)
+						Loop<SimpleShade, NearestFilter, TextureSize64x64>(texdata, shade_constants);
+					else
+						Loop<SimpleShade, NearestFilter, TextureSizeAny>(texdata, shade_constants);
+				}
+				else
+				{
+					if (is_64x64)
+						Loop<SimpleShade, LinearFilter, TextureSize64x64>(texdata, shade_constants);
+					else
+						Loop<SimpleShade, LinearFilter, TextureSizeAny>(texdata, shade_constants);
+				}
+			}
+			else
+			{
+				if (is_nearest_filter)
+				{
+					if (is_64x64)
+						Loop<AdvancedShade, NearestFilter, TextureSize64x64>(texdata, shade_constants);
+					else
+						Loop<AdvancedShade, NearestFilter, TextureSizeAny>(texdata, shade_constants);
+				}
+				else
+				{
+					if (is_64x64)
+						Loop<AdvancedShade, LinearFilter, TextureSize64x64>(texdata, shade_constants);
+					else
+						Loop<AdvancedShade, LinearFilter, TextureSizeAny>(texdata, shade_constants);
+				}
+			}
+		}
+
+	private:
+		// Four pixels worth of 16 bit channels, in the same order as _mm_set_epi16
+		AVX2_TARGET static FORCEINLINE __m256i VECTORCALL Channels(int a, int r, int g, int b)
+		{
+			return _mm256_set1_epi64x((int64_t)(uint16_t)a << 48 | (int64_t)(uint16_t)r << 32 | (int64_t)(uint16_t)g << 16 | (int64_t)(uint16_t)b);
+		}
+
+		// Spreads the low 16 bits of four of the eight 32 bit values over all channels of their pixel
+		AVX2_TARGET static FORCEINLINE __m256i VECTORCALL Expand(__m256i values, __m256i index)
+		{
+			__m256i v = _mm256_permutevar8x32_epi32(values, index);
+			v = _mm256_shufflelo_epi16(v, _MM_SHUFFLE(2, 2, 0, 0));
+			return _mm256_shufflehi_epi16(v, _MM_SHUFFLE(2, 2, 0, 0));
+		}
+
+		template<typename ShadeModeT, typename FilterModeT, typename TextureSizeT>
+		AVX2_TARGET FORCEINLINE void VECTORCALL Loop(TextureData texdata, ShadeConstants shade_constants)
+		{
+			using namespace DrawSpan32TModes;
+
+			const SpanDrawerArgs &args = this->args;
+
+			// Shade constants
+			int light = 256 - (args.Light() >> (FRACBITS - 8));
+			__m256i mlight = Channels(256, light, light, light);
+			__m256i inv_light = Channels(0, 256 - light, 256 - light, 256 - light);
+
+			__m256i inv_desaturate, shade_fade, shade_light, desaturate;
+			if (ShadeModeT::Mode == (int)ShadeMode::Advanced)
+			{
+				// Channel order matches the SSE2 drawer, which sets these with _mm_setr_epi16
+				int inv = 256 - shade_constants.desaturate;
+				inv_desaturate = Channels(inv, inv, inv, 256);
+				shade_fade = Channels(shade_constants.fade_alpha, shade_constants.fade_red, shade_constants.fade_green, shade_constants.fade_blue);
+				shade_fade = _mm256_mullo_epi16(shade_fade, inv_light);
+				shade_light = Channels(shade_constants.light_alpha, shade_constants.light_red, shade_constants.light_green, shade_constants.light_blue);
+				desaturate = _mm256_set1_epi16(shade_constants.desaturate);
+			}
+			else
+			{
+				inv_desaturate = _mm256_setzero_si256();
+				shade_fade = _mm256_setzero_si256();
+				shade_light = _mm256_setzero_si256();
+				desaturate = _mm256_setzero_si256();
+			}
+
+			auto lights = args.dc_lights;
+			auto num_lights = args.dc_num_lights;
+			float vpx = args.dc_viewpos.X;
+			float stepvpx = args.dc_viewpos_step.X;
+			__m256 viewpos_x = _mm256_add_ps(_mm256_set1_ps(vpx), _mm256_mul_ps(_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f), _mm256_set1_ps(stepvpx)));
+			__m256 step_viewpos_x = _mm256_set1_ps(stepvpx * 8.0f);
+
+			int count = args.DestX2() - args.DestX1() + 1;
+			uint32_t *dest = (uint32_t*)args.Viewport()->GetDest(args.DestX1(), args.DestY());
+
+			if (FilterModeT::Mode == (int)FilterModes::Linear)
+			{
+				texdata.xfrac -= texdata.xone / 2;
+				texdata.yfrac -= texdata.yone / 2;
+			}
+
+			uint32_t srcalpha = args.SrcAlpha() >> (FRACBITS - 8);
+			uint32_t destalpha = args.DestAlpha() >> (FRACBITS - 8);
+
+			int avxcount = count / 8;
+			for (int index = 0; index < avxcount; index++)
+			{
+				uint32_t *d = dest + index * 8;
+
+				__m256i texels = Sample8<FilterModeT, TextureSizeT>(texdata, 8);
+				__m256i bgcolor = BlendT::Mode != (int)SpanBlendModes::Opaque ? _mm256_loadu_si256((const __m256i*)d) : _mm256_setzero_si256();
+
+				__m256i outcolor = ShadeAndBlend<ShadeModeT>(texels, bgcolor, mlight, desaturate, inv_desaturate, shade_fade, shade_light, lights, num_lights, viewpos_x, srcalpha, destalpha);
+				_mm256_storeu_si256((__m256i*)d, outcolor);
+
+				viewpos_x = _mm256_add_ps(viewpos_x, step_viewpos_x);
+			}
+
+			int rest = count - avxcount * 8;
+			if (rest > 0)
+			{
+				uint32_t *d = dest + avxcount * 8;
+				__m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(rest), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+				__m256i texels = Sample8<FilterModeT, TextureSizeT>(texdata, rest);
+				__m256i bgcolor = BlendT::Mode != (int)SpanBlendModes::Opaque ? _mm256_maskload_epi32((const int*)d, mask) : _mm256_setzero_si256();
+
+				__m256i outcolor = ShadeAndBlend<ShadeModeT>(texels, bgcolor, mlight, desaturate, inv_desaturate, shade_fade, shade_light, lights, num_lights, viewpos_x, srcalpha, destalpha);
+				_mm256_maskstore_epi32((int*)d, mask, outcolor);
+			}
+		}
+
+		// Fetches the next 'count' texels of the span. Unused lanes are zero.
+		template<typename FilterModeT, typename TextureSizeT>
+		AVX2_TARGET FORCEINLINE __m256i VECTORCALL Sample8(TextureData &texdata, int count)
+		{
+			using namespace DrawSpan32TModes;
+
+			if (FilterModeT::Mode == (int)FilterModes::Nearest && count == 8)
+			{
+				__m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+				__m256i xfrac = _mm256_add_epi32(_mm256_set1_epi32(texdata.xfrac), _mm256_mullo_epi32(lane, _mm256_set1_epi32(texdata.xstep)));
+				__m256i yfrac = _mm256_add_epi32(_mm256_set1_epi32(texdata.yfrac), _mm256_mullo_epi32(lane, _mm256_set1_epi32(texdata.ystep)));
+				texdata.xfrac += texdata.xstep * 8;
+				texdata.yfrac += texdata.ystep * 8;
+
+				__m256i sample_index;
+				if (TextureSizeT::Mode == (int)SpanTextureSize::Size64x64)
+				{
+					sample_index = _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(xfrac, 32 - 6 - 6), _mm256_set1_epi32(63 * 64)), _mm256_srli_epi32(yfrac, 32 - 6));
+				}
+				else
+				{
+					__m256i x = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(xfrac, 16), _mm256_set1_epi32(texdata.width)), 16);
+					__m256i y = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(yfrac, 16), _mm256_set1_epi32(texdata.height)), 16);
+					sample_index = _mm256_add_epi32(_mm256_mullo_epi32(x, _mm256_set1_epi32(texdata.height)), y);
+				}
+				return _mm256_i32gather_epi32((const int*)texdata.source, sample_index, 4);
+			}
+			else
+			{
+				alignas(32) uint32_t texels[8] = { 0 };
+				for (int i = 0; i < count; i++)
+				{
+					texels[i] = Super::template Sample<FilterModeT, TextureSizeT>(texdata.width, texdata.height, texdata.xone, texdata.yone, texdata.xstep, texdata.ystep, texdata.xfrac, texdata.yfrac, texdata.source);
+					texdata.xfrac += texdata.xstep;
+					texdata.yfrac += texdata.ystep;
+				}
+				return _mm256_load_si256((const __m256i*)texels);
+			}
+		}
+
+		template<typename ShadeModeT>
+		AVX2_TARGET FORCEINLINE __m256i VECTORCALL ShadeAndBlend(__m256i texels, __m256i bgcolor, __m256i mlight, __m256i desaturate, __m256i inv_desaturate, __m256i shade_fade, __m256i shade_light, const DrawerLight *lights, int num_lights, __m256 viewpos_x, uint32_t srcalpha, uint32_t destalpha)
+		{
+			using namespace DrawSpan32TModes;
+
+			// Pixels 0-3 and 4-7 as 16 bit channels
+			__m256i material_lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(texels));
+			__m256i material_hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(texels, 1));
+
+			__m256i fg_lo = Shade<ShadeModeT>(material_lo, mlight, desaturate, inv_desaturate, shade_fade, shade_light);
+			__m256i fg_hi = Shade<ShadeModeT>(material_hi, mlight, desaturate, inv_desaturate, shade_fade, shade_light);
+			AddLights(material_lo, material_hi, fg_lo, fg_hi, lights, num_lights, viewpos_x);
+
+			return Blend(fg_lo, fg_hi, bgcolor, texels, srcalpha, destalpha);
+		}
+
+		template<typename ShadeModeT>
+		AVX2_TARGET FORCEINLINE __m256i VECTORCALL Shade(__m256i fgcolor, __m256i mlight, __m256i desaturate, __m256i inv_desaturate, __m256i shade_fade, __m256i shade_light)
+		{
+			using namespace DrawSpan32TModes;
+
+			if (ShadeModeT::Mode == (int)ShadeMode::Simple)
+			{
+				return _mm256_srli_epi16(_mm256_mullo_epi16(fgcolor, mlight), 8);
+			}
+			else
+			{
+				// (red * 77 + green * 143 + blue * 37) >> 8, copied to the color channels of each pixel
+				__m256i sum = _mm256_madd_epi16(fgcolor, Channels(0, 77, 143, 37));
+				sum = _mm256_add_epi32(sum, _mm256_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+				sum = _mm256_srli_epi32(sum, 8);
+				sum = _mm256_shufflelo_epi16(sum, _MM_SHUFFLE(1, 0, 0, 0));
+				sum = _mm256_shufflehi_epi16(sum, _MM_SHUFFLE(1, 0, 0, 0));
+				__m256i intensity = _mm256_mullo_epi16(sum, desaturate);
+
+				fgcolor = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(fgcolor, inv_desaturate), intensity), 8);
+				fgcolor = _mm256_mullo_epi16(fgcolor, mlight);
+				fgcolor = _mm256_srli_epi16(_mm256_add_epi16(shade_fade, fgcolor), 8);
+				return _mm256_srli_epi16(_mm256_mullo_epi16(fgcolor, shade_light), 8);
+			}
+		}
+
+		AVX2_TARGET FORCEINLINE void VECTORCALL AddLights(__m256i material_lo, __m256i material_hi, __m256i &fg_lo, __m256i &fg_hi, const DrawerLight *lights, int num_lights, __m256 viewpos_x)
+		{
+			__m256i index_lo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+			__m256i index_hi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+			__m256i lit_lo = _mm256_setzero_si256();
+			__m256i lit_hi = _mm256_setzero_si256();
+
+			for (int i = 0; i != num_lights; i++)
+			{
+				__m256 light_x = _mm256_set1_ps(lights[i].x);
+				__m256 light_y = _mm256_set1_ps(lights[i].y);
+				__m256 light_z = _mm256_set1_ps(lights[i].z);
+				__m256 light_radius = _mm256_set1_ps(lights[i].radius);
+				__m256 m256 = _mm256_set1_ps(256.0f);
+
+				// See DrawSpan32T::AddLights
+				__m256 Lyz2 = light_y;
+				__m256 Lx = _mm256_sub_ps(light_x, viewpos_x);
+				__m256 dist2 = _mm256_add_ps(Lyz2, _mm256_mul_ps(Lx, Lx));
+				__m256 rcp_dist = _mm256_rsqrt_ps(dist2);
+				__m256 dist = _mm256_mul_ps(dist2, rcp_dist);
+				__m256 distance_attenuation = _mm256_sub_ps(m256, _mm256_min_ps(_mm256_mul_ps(dist, light_radius), m256));
+
+				__m256 simple_attenuation = distance_attenuation;
+				__m256 point_attenuation = _mm256_mul_ps(_mm256_mul_ps(light_z, rcp_dist), distance_attenuation);
+
+				__m256 is_attenuated = _mm256_cmp_ps(light_z, _mm256_setzero_ps(), _CMP_EQ_OQ);
+				__m256i attenuation = _mm256_cvtps_epi32(_mm256_blendv_ps(point_attenuation, simple_attenuation, is_attenuated));
+				attenuation = _mm256_max_epi32(_mm256_min_epi32(attenuation, _mm256_set1_epi32(32767)), _mm256_set1_epi32(-32768)); // same saturation as _mm_packs_epi32
+
+				__m256i light_color = _mm256_broadcastq_epi64(_mm_unpacklo_epi8(_mm_cvtsi32_si128(lights[i].color), _mm_setzero_si128()));
+
+				lit_lo = _mm256_add_epi16(lit_lo, _mm256_srli_epi16(_mm256_mullo_epi16(light_color, Expand(attenuation, index_lo)), 8));
+				lit_hi = _mm256_add_epi16(lit_hi, _mm256_srli_epi16(_mm256_mullo_epi16(light_color, Expand(attenuation, index_hi)), 8));
+			}
+
+			lit_lo = _mm256_min_epi16(lit_lo, _mm256_set1_epi16(256));
+			lit_hi = _mm256_min_epi16(lit_hi, _mm256_set1_epi16(256));
+
+			fg_lo = _mm256_add_epi16(fg_lo, _mm256_srli_epi16(_mm256_mullo_epi16(material_lo, lit_lo), 8));
+			fg_hi = _mm256_add_epi16(fg_hi, _mm256_srli_epi16(_mm256_mullo_epi16(material_hi, lit_hi), 8));
+			fg_lo = _mm256_min_epi16(fg_lo, _mm256_set1_epi16(255));
+			fg_hi = _mm256_min_epi16(fg_hi, _mm256_set1_epi16(255));
+		}
+
+		// Packs two sets of four 16 bit pixels back into eight 32 bit ones
+		AVX2_TARGET static FORCEINLINE __m256i VECTORCALL Pack(__m256i lo, __m256i hi)
+		{
+			__m256i color = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+			return _mm256_or_si256(color, _mm256_set1_epi32(0xff000000));
+		}
+
+		AVX2_TARGET FORCEINLINE __m256i VECTORCALL Blend(__m256i fg_lo, __m256i fg_hi, __m256i bgcolor, __m256i texels, uint32_t srcalpha, uint32_t destalpha)
+		{
+			using namespace DrawSpan32TModes;
+
+			if (BlendT::Mode == (int)SpanBlendModes::Opaque)
+			{
+				return Pack(fg_lo, fg_hi);
+			}
+			else if (BlendT::Mode == (int)SpanBlendModes::Masked)
+			{
+				__m256i fgcolor = _mm256_permute4x64_epi64(_mm256_packus_epi16(fg_lo, fg_hi), _MM_SHUFFLE(3, 1, 2, 0));
+				__m256i mask = _mm256_cmpeq_epi32(fgcolor, _mm256_setzero_si256());
+				__m256i outcolor = _mm256_blendv_epi8(fgcolor, bgcolor, mask);
+				return _mm256_or_si256(outcolor, _mm256_set1_epi32(0xff000000));
+			}
+
+			__m256i fgalpha_lo, fgalpha_hi, bgalpha_lo, bgalpha_hi;
+			if (BlendT::Mode == (int)SpanBlendModes::Translucent)
+			{
+				fgalpha_lo = fgalpha_hi = _mm256_set1_epi16(srcalpha);
+				bgalpha_lo = bgalpha_hi = _mm256_set1_epi16(destalpha);
+			}
+			else
+			{
+				__m256i alpha = _mm256_srli_epi32(texels, 24);
+				alpha = _mm256_add_epi32(alpha, _mm256_srli_epi32(alpha, 7)); // 255->256
+				__m256i inv_alpha = _mm256_sub_epi32(_mm256_set1_epi32(256), alpha);
+
+				__m256i round = _mm256_set1_epi32(128);
+				__m256i bgalpha = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(destalpha), alpha), _mm256_slli_epi32(inv_alpha, 8)), round), 8);
+				__m256i fgalpha = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(srcalpha), alpha), round), 8);
+
+				__m256i index_lo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+				__m256i index_hi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+				fgalpha_lo = Expand(fgalpha, index_lo);
+				fgalpha_hi = Expand(fgalpha, index_hi);
+				bgalpha_lo = Expand(bgalpha, index_lo);
+				bgalpha_hi = Expand(bgalpha, index_hi);
+			}
+
+			__m256i bg_lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bgcolor));
+			__m256i bg_hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bgcolor, 1));
+
+			__m256i out_lo = BlendChannels(_mm256_mullo_epi16(fg_lo, fgalpha_lo), _mm256_mullo_epi16(bg_lo, bgalpha_lo));
+			__m256i out_hi = BlendChannels(_mm256_mullo_epi16(fg_hi, fgalpha_hi), _mm256_mullo_epi16(bg_hi, bgalpha_hi));
+			return Pack(out_lo, out_hi);
+		}
+
+		// Combines premultiplied 16 bit channels in 32 bit precision
+		AVX2_TARGET static FORCEINLINE __m256i VECTORCALL BlendChannels(__m256i fgcolor, __m256i bgcolor)
+		{
+			using namespace DrawSpan32TModes;
+
+			__m256i fg_lo = _mm256_unpacklo_epi16(fgcolor, _mm256_setzero_si256());
+			__m256i bg_lo = _mm256_unpacklo_epi16(bgcolor, _mm256_setzero_si256());
+			__m256i fg_hi = _mm256_unpackhi_epi16(fgcolor, _mm256_setzero_si256());
+			__m256i bg_hi = _mm256_unpackhi_epi16(bgcolor, _mm256_setzero_si256());
+
+			__m256i out_lo, out_hi;
+			if (BlendT::Mode == (int)SpanBlendModes::SubClamp)
+			{
+				out_lo = _mm256_sub_epi32(fg_lo, bg_lo);
+				out_hi = _mm256_sub_epi32(fg_hi, bg_hi);
+			}
+			else if (BlendT::Mode == (int)SpanBlendModes::RevSubClamp)
+			{
+				out_lo = _mm256_sub_epi32(bg_lo, fg_lo);
+				out_hi = _mm256_sub_epi32(bg_hi, fg_hi);
+			}
+			else
+			{
+				out_lo = _mm256_add_epi32(fg_lo, bg_lo);
+				out_hi = _mm256_add_epi32(fg_hi, bg_hi);
+			}
+
+			out_lo = _mm256_srai_epi32(out_lo, 8);
+			out_hi = _mm256_srai_epi32(out_hi, 8);
+			return _mm256_packs_epi32(out_lo, out_hi);
+		}
+	};
+
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::OpaqueSpan> DrawSpan32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::MaskedSpan> DrawSpanMasked32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::TranslucentSpan> DrawSpanTranslucent32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::AddClampSpan> DrawSpanAddClamp32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::SubClampSpan> DrawSpanSubClamp32AVX2Command;
+	typedef DrawSpan32AVX2T<DrawSpan32TModes::RevSubClampSpan> DrawSpanRevSubClamp32AVX2Command;
+}
@@ -79,40 +79,9 @@ namespace swrenderer
 			if (thread->line_skipped_by_thread(args.DestY())) return;
 			
 			TextureData texdata;
-			texdata.width = args.TextureWidth();
-			texdata.height = args.TextureHeight();
-			texdata.xstep = args.TextureUStep();
-			texdata.ystep = args.TextureVStep();
-			texdata.xfrac = args.TextureUPos();
-			texdata.yfrac = args.TextureVPos();
-			
-			texdata.source = (const uint32_t*)args.TexturePixels();
-			
-			double lod = args.TextureLOD();
-			bool mipmapped = args.MipmappedTexture();
-			
-			bool magnifying = lod < 0.0;
-			if (r_mipmap && mipmapped)
-			{
-				int level = (int)lod;
-				while (level > 0)
-				{
-					if (texdata.width <= 2 || texdata.height <= 2)
-						break;
-
-					texdata.source += texdata.width * texdata.height;
-					texdata.width = MAX<uint32_t>(texdata.width / 2, 1);
-					texdata.height = MAX<uint32_t>(texdata.height / 2, 1);
-					level--;
-				}
-			}
-
-			texdata.xone = (0x80000000u / texdata.width) << 1;
-			texdata.yone = (0x80000000u / texdata.height) << 1;
+			bool is_nearest_filter, is_64x64;
+			SetupTexture(texdata, is_nearest_filter, is_64x64);
 
-			bool is_nearest_filter = (magnifying && !r_magfilter) || (!magnifying && !r_minfilter);
-			bool is_64x64 = texdata.width == 64 && texdata.height == 64;
-			
 			auto shade_constants = args.ColormapConstants();
 			if (shade_constants.simple_shade)
 			{
@@ -150,6 +119,44 @@ namespace swrenderer
 			}
 		}
 
+		// Picks the mipmap level and filter for the span
+		void SetupTexture(TextureData &texdata, bool &is_nearest_filter, bool &is_64x64)
+		{
+			texdata.width = args.TextureWidth();
+			texdata.height = args.TextureHeight();
+			texdata.xstep = args.TextureUStep();
+			texdata.ystep = args.TextureVStep();
+			texdata.xfrac = args.TextureUPos();
+			texdata.yfrac = args.TextureVPos();
+			
+			texdata.source = (const uint32_t*)args.TexturePixels();
+			
+			double lod = args.TextureLOD();
+			bool mipmapped = args.MipmappedTexture();
+			
+			bool magnifying = lod < 0.0;
+			if (r_mipmap && mipmapped)
+			{
+				int level = (int)lod;
+				while (level > 0)
+				{
+					if (texdata.width <= 2 || texdata.height <= 2)
+						break;
+
+					texdata.source += texdata.width * texdata.height;
+					texdata.width = MAX<uint32_t>(texdata.width / 2, 1);
+					texdata.height = MAX<uint32_t>(texdata.height / 2, 1);
+					level--;
+				}
+			}
+
+			texdata.xone = (0x80000000u / texdata.width) << 1;
+			texdata.yone = (0x80000000u / texdata.height) << 1;
+
+			is_nearest_filter = (magnifying && !r_magfilter) || (!magnifying && !r_minfilter);
+			is_64x64 = texdata.width == 64 && texdata.height == 64;
+		}
+
 		template<typename ShadeModeT, typename FilterModeT, typename TextureSizeT>
 		FORCEINLINE void VECTORCALL Loop(DrawerThread *thread, TextureData texdata, ShadeConstants shade_constants)
 		{
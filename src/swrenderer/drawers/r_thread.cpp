@@ -42,6 +42,12 @@ void PeekThreadedErrorPane();
 CVAR(Int, r_multithreaded, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 CVAR(Int, r_debug_draw, 0, 0);
 
+// Height of the screen tile rows handed out to each thread by the binned (softpoly) drawers
+CUSTOM_CVAR(Int, r_drawbinheight, 64, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 1) self = 1;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 DrawerThreads *DrawerThreads::Instance()
@@ -127,6 +133,14 @@ void DrawerThreads::WaitForWorkers()
 	queue->active_commands.clear();
 }
 
+// Whole tile rows keep the framebuffer, depth and stencil lines of a thread in its own
+// caches, but each core still needs a few of them to even out the load across the screen.
+int DrawerThreads::GetBinHeight(DrawerThread *thread)
+{
+	int height = (thread->numa_end_y - thread->numa_start_y) / (thread->num_cores * 4);
+	return clamp<int>(height, 1, r_drawbinheight);
+}
+
 void DrawerThreads::WorkerMain(DrawerThread *thread)
 {
 	while (true)
@@ -142,10 +156,12 @@ void DrawerThreads::WorkerMain(DrawerThread *thread)
 		thread->current_queue++;
 		thread->numa_start_y = thread->numa_node * screen->GetHeight() / thread->num_numa_nodes;
 		thread->numa_end_y = (thread->numa_node + 1) * screen->GetHeight() / thread->num_numa_nodes;
+		thread->bin_height = list->Binned ? GetBinHeight(thread) : 1;
 		if (thread->poly)
 		{
 			thread->poly->numa_start_y = thread->numa_start_y;
 			thread->poly->numa_end_y = thread->numa_end_y;
+			thread->poly->bin_height = thread->bin_height;
 		}
 		start_lock.unlock();
 
@@ -250,13 +266,13 @@ void DrawerThreads::StopThreads()
 
 /////////////////////////////////////////////////////////////////////////////
 
-DrawerCommandQueue::DrawerCommandQueue(RenderMemory *frameMemory) : FrameMemory(frameMemory)
+DrawerCommandQueue::DrawerCommandQueue(RenderMemory *frameMemory, bool binned) : FrameMemory(frameMemory), Binned(binned)
 {
 }
 
-void *DrawerCommandQueue::AllocMemory(size_t size)
+void *DrawerCommandQueue::AllocMemory(size_t size, size_t alignment)
 {
-	return FrameMemory->AllocMemory<uint8_t>((int)size);
+	return FrameMemory->AllocBytes(size, alignment);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -278,17 +294,14 @@ MemcpyCommand::MemcpyCommand(void *dest, const void *src, int width, int height,
 
 void MemcpyCommand::Execute(DrawerThread *thread)
 {
-	int start = thread->skipped_by_thread(0);
-	int count = thread->count_for_thread(0, height);
-	int sstep = thread->num_cores * srcpitch * pixelsize;
-	int dstep = thread->num_cores * width * pixelsize;
 	int size = width * pixelsize;
-	uint8_t *d = (uint8_t*)dest + start * width * pixelsize;
-	const uint8_t *s = (const uint8_t*)src + start * srcpitch * pixelsize;
-	for (int i = 0; i < count; i++)
+	int y1 = MIN(height, thread->numa_end_y);
+	int y = thread->skipped_by_thread(0);
+	while (y < y1)
 	{
-		memcpy(d, s, size);
-		d += dstep;
-		s += sstep;
+		int end = MIN(thread->bin_end_for_thread(y), y1);
+		for (; y < end; y++)
+			memcpy((uint8_t*)dest + y * width * pixelsize, (const uint8_t*)src + y * srcpitch * pixelsize, size);
+		y += thread->skipped_by_thread(y);
 	}
 }
@@ -57,6 +57,10 @@ public:
 	int numa_start_y = 0;
 	int numa_end_y = MAXHEIGHT;
 
+	// Lines are handed out to the cores in bins of this many lines. The column and span
+	// drawers step through their lines with a pitch of num_cores and need it to be 1.
+	int bin_height = 1;
+
 	// Working buffer used by the tilted (sloped) span drawer
 	const uint8_t *tiltlighting[MAXWIDTH];
 
@@ -67,18 +71,27 @@ public:
 	// Checks if a line is rendered by this thread
 	bool line_skipped_by_thread(int line)
 	{
-		return line < numa_start_y || line >= numa_end_y || line % num_cores != core;
+		return line < numa_start_y || line >= numa_end_y || (line / bin_height) % num_cores != core;
 	}
 
 	// The number of lines to skip to reach the first line to be rendered by this thread
 	int skipped_by_thread(int first_line)
 	{
 		int clip_first_line = MAX(first_line, numa_start_y);
-		int core_skip = (num_cores - (clip_first_line - core) % num_cores) % num_cores;
-		return clip_first_line + core_skip - first_line;
+		int bin = clip_first_line / bin_height;
+		int core_skip = (num_cores - (bin - core) % num_cores) % num_cores;
+		if (core_skip != 0)
+			clip_first_line = (bin + core_skip) * bin_height;
+		return clip_first_line - first_line;
 	}
 
-	// The number of lines to be rendered by this thread
+	// The end of the bin the line is in (exclusive)
+	int bin_end_for_thread(int line)
+	{
+		return MIN((line / bin_height + 1) * bin_height, numa_end_y);
+	}
+
+	// The number of lines to be rendered by this thread (requires a bin height of 1)
 	int count_for_thread(int first_line, int count)
 	{
 		count = MIN(count, numa_end_y - first_line);
@@ -158,6 +171,7 @@ private:
 	void StartThreads();
 	void StopThreads();
 	void WorkerMain(DrawerThread *thread);
+	static int GetBinHeight(DrawerThread *thread);
 
 	static DrawerThreads *Instance();
 	
@@ -185,7 +199,7 @@ class RenderMemory;
 class DrawerCommandQueue
 {
 public:
-	DrawerCommandQueue(RenderMemory *memoryAllocator);
+	DrawerCommandQueue(RenderMemory *memoryAllocator, bool binned = false);
 	
 	void Clear() { commands.clear(); }
 	
@@ -196,7 +210,7 @@ public:
 		DrawerThreads *threads = DrawerThreads::Instance();
 		if (r_multithreaded != 0)
 		{
-			void *ptr = AllocMemory(sizeof(T));
+			void *ptr = AllocMemory(sizeof(T), alignof(T));
 			T *command = new (ptr)T(std::forward<Types>(args)...);
 			commands.push_back(command);
 		}
@@ -209,10 +223,13 @@ public:
 	
 private:
 	// Allocate memory valid for the duration of a command execution
-	void *AllocMemory(size_t size);
+	void *AllocMemory(size_t size, size_t alignment);
 	
 	std::vector<DrawerCommand *> commands;
 	RenderMemory *FrameMemory;
+
+	// All commands in the queue can deal with lines assigned in bins (see DrawerThread::bin_height)
+	bool Binned;
 	
 	friend class DrawerThreads;
 };
@@ -51,6 +51,10 @@
 #include "swrenderer/line/r_wallsetup.h"
 #include "swrenderer/r_renderthread.h"
 #include "swrenderer/r_memory.h"
+#include "swrenderer/drawers/r_draw_pal.h"
+
+// Draw opaque paletted wall columns four at a time
+CVAR(Bool, r_batchwalls, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 namespace swrenderer
 {
@@ -331,6 +335,41 @@ namespace swrenderer
 		}
 	}
 
+	void RenderWallPart::BatchColumn(int x, int y1, int y2, WallSampler &sampler)
+	{
+		if (batch.count > 0 && batchx + batch.count != x)
+			FlushColumnBatch();
+
+		if (batch.count == 0)
+		{
+			auto viewport = Thread->Viewport.get();
+			batchx = x;
+			batch.dest = viewport->GetDest(x, 0);
+			batch.pitch = viewport->RenderTarget->GetPitch();
+			batch.fracbits = drawerargs.TextureFracBits();
+		}
+
+		WallColumnBatch::Column &column = batch.columns[batch.count++];
+		column.source = sampler.source;
+		column.colormap = drawerargs.Colormap(Thread->Viewport.get());
+		column.texturefrac = sampler.uv_pos;
+		column.iscale = sampler.uv_step;
+		column.y1 = y1;
+		column.y2 = y2;
+
+		if (batch.count == WallColumnBatch::MaxColumns)
+			FlushColumnBatch();
+	}
+
+	void RenderWallPart::FlushColumnBatch()
+	{
+		if (batch.count > 0)
+		{
+			Thread->DrawQueue->Push<DrawWall4PalCommand>(batch);
+			batch.count = 0;
+		}
+	}
+
 	void RenderWallPart::ProcessWallWorker(const short *uwal, const short *dwal, double texturemid, float *swal, fixed_t *lwal)
 	{
 		if (rw_pic == nullptr)
@@ -368,6 +407,10 @@ namespace swrenderer
 
 		double xmagnitude = 1.0;
 
+		// Columns that only need a plain texture lookup can be drawn together. Dynamic lights,
+		// the depth buffer and non-power-of-two wrapping still go through Draw1Column.
+		bool batching = r_batchwalls && !Thread->Viewport->RenderTarget->IsBgra() && drawerargs.IsOpaqueColumn() && !r_modelscene && !(r_dynlights && light_list);
+
 		float curlight = light;
 		for (int x = x1; x < x2; x++, curlight += lightstep)
 		{
@@ -382,8 +425,17 @@ namespace swrenderer
 			if (x + 1 < x2) xmagnitude = fabs(FIXED2DBL(lwal[x + 1]) - FIXED2DBL(lwal[x]));
 
 			WallSampler sampler(Thread->Viewport.get(), y1, texturemid, swal[x], yrepeat, lwal[x] + xoffset, xmagnitude, rw_pic);
-			Draw1Column(x, y1, y2, sampler);
+			if (batching && (sampler.uv_max == 0 || sampler.uv_step == 0))
+			{
+				BatchColumn(x, y1, y2, sampler);
+			}
+			else
+			{
+				FlushColumnBatch();
+				Draw1Column(x, y1, y2, sampler);
+			}
 		}
+		FlushColumnBatch();
 
 		if (Thread->MainThread)
 			NetUpdate();
@@ -80,6 +80,8 @@ namespace swrenderer
 		void ProcessNormalWall(const short *uwal, const short *dwal, double texturemid, float *swal, fixed_t *lwal);
 		void ProcessWallWorker(const short *uwal, const short *dwal, double texturemid, float *swal, fixed_t *lwal);
 		void Draw1Column(int x, int y1, int y2, WallSampler &sampler);
+		void BatchColumn(int x, int y1, int y2, WallSampler &sampler);
+		void FlushColumnBatch();
 
 		int x1 = 0;
 		int x2 = 0;
@@ -101,6 +103,9 @@ namespace swrenderer
 		fixed_t alpha = 0;
 
 		WallDrawerArgs drawerargs;
+
+		WallColumnBatch batch;
+		int batchx = 0;
 	};
 
 	struct WallSampler
@@ -36,30 +36,128 @@
 #include "r_sky.h"
 #include "po_man.h"
 #include "r_data/colormaps.h"
+#include "stats.h"
 #include "r_memory.h"
+#include <mutex>
+#include <algorithm>
 
-void *RenderMemory::AllocBytes(int size)
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// All frame arenas, for ADD_STAT(rendermemory)
+static std::mutex ArenaMutex;
+static std::vector<RenderMemory *> Arenas;
+
+RenderMemory::RenderMemory()
+{
+	std::unique_lock<std::mutex> lock(ArenaMutex);
+	Arenas.push_back(this);
+}
+
+RenderMemory::~RenderMemory()
 {
-	size = (size + 15) / 16 * 16; // 16-byte align
-		
-	if (UsedBlocks.empty() || UsedBlocks.back()->Position + size > BlockSize)
+	std::unique_lock<std::mutex> lock(ArenaMutex);
+	Arenas.erase(std::find(Arenas.begin(), Arenas.end(), this));
+}
+
+RenderMemory::MemoryBlock::MemoryBlock(size_t size) : Size(size), Position(0)
+{
+#ifdef __linux__
+	// Map an extra page so that the block can start on a 2 MB boundary, which
+	// transparent huge pages need, and unmap what is left over on either side.
+	const size_t pagesize = BlockSize;
+	uint8_t *ptr = (uint8_t *)mmap(nullptr, size + pagesize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ptr == MAP_FAILED)
+		throw std::bad_alloc();
+
+	uint8_t *start = (uint8_t *)(((uintptr_t)ptr + pagesize - 1) & ~(uintptr_t)(pagesize - 1));
+	if (start != ptr)
+		munmap(ptr, start - ptr);
+	if (start + size != ptr + size + pagesize)
+		munmap(start + size, (ptr + size + pagesize) - (start + size));
+#ifdef MADV_HUGEPAGE
+	madvise(start, size, MADV_HUGEPAGE);
+#endif
+	Data = start;
+#else
+	Data = new uint8_t[size];
+#endif
+}
+
+RenderMemory::MemoryBlock::~MemoryBlock()
+{
+#ifdef __linux__
+	munmap(Data, Size);
+#else
+	delete[] Data;
+#endif
+}
+
+void *RenderMemory::AllocBytes(size_t size, size_t alignment)
+{
+	if (alignment < 16)
+		alignment = 16;
+	size = (size + 15) / 16 * 16; // keep the next allocation 16-byte aligned
+
+	uint8_t *data = nullptr;
+	size_t padding = 0;
+
+	// Room left in the current block?
+	if (!UsedBlocks.empty())
 	{
-		if (!FreeBlocks.empty())
+		auto &block = UsedBlocks.back();
+		uintptr_t pos = (uintptr_t)(block->Data + block->Position);
+		padding = ((pos + alignment - 1) & ~(uintptr_t)(alignment - 1)) - pos;
+		if (block->Position + padding + size <= block->Size)
 		{
-			auto block = std::move(FreeBlocks.back());
-			block->Position = 0;
-			FreeBlocks.pop_back();
-			UsedBlocks.push_back(std::move(block));
+			data = block->Data + block->Position + padding;
+			block->Position += padding + size;
+		}
+	}
+
+	if (data == nullptr)
+	{
+		size_t needed = size + alignment;
+		bool large = needed > BlockSize / 4;
+
+		// Reuse the smallest free block that is big enough
+		int best = -1;
+		for (size_t i = 0; i < FreeBlocks.size(); i++)
+		{
+			if (FreeBlocks[i]->Size >= needed && (best == -1 || FreeBlocks[i]->Size < FreeBlocks[best]->Size))
+				best = (int)i;
+		}
+
+		std::unique_ptr<MemoryBlock> block;
+		if (best != -1)
+		{
+			block = std::move(FreeBlocks[best]);
+			FreeBlocks.erase(FreeBlocks.begin() + best);
 		}
 		else
 		{
-			UsedBlocks.push_back(std::unique_ptr<MemoryBlock>(new MemoryBlock()));
+			size_t blocksize = (needed + BlockSize - 1) / BlockSize * BlockSize;
+			block.reset(new MemoryBlock(blocksize));
+			Reserved += blocksize;
+			BlockAllocations++;
 		}
+
+		uintptr_t pos = (uintptr_t)block->Data;
+		padding = ((pos + alignment - 1) & ~(uintptr_t)(alignment - 1)) - pos;
+		block->Position = padding + size;
+		data = block->Data + padding;
+
+		// A large allocation gets a block of its own and the current block stays open for the small ones
+		if (large && !UsedBlocks.empty())
+			UsedBlocks.insert(UsedBlocks.end() - 1, std::move(block));
+		else
+			UsedBlocks.push_back(std::move(block));
 	}
-		
-	auto &block = UsedBlocks.back();
-	void *data = block->Data + block->Position;
-	block->Position += size;
+
+	UsedBytes += padding + size;
+	if (UsedBytes > PeakBytes)
+		PeakBytes = UsedBytes;
 
 	return data;
 }
@@ -72,4 +170,20 @@ void RenderMemory::Clear()
 		UsedBlocks.pop_back();
 		FreeBlocks.push_back(std::move(block));
 	}
+	UsedBytes = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+ADD_STAT(rendermemory)
+{
+	FString out;
+	out.Format("frame/peak/reserved KB (block allocs):");
+	std::unique_lock<std::mutex> lock(ArenaMutex);
+	for (size_t i = 0; i < Arenas.size(); i++)
+	{
+		RenderMemory *arena = Arenas[i];
+		out.AppendFormat("  %d: %d/%d/%d (%d)", (int)i, (int)(arena->FrameBytes() / 1024), (int)(arena->PeakFrameBytes() / 1024), (int)(arena->ReservedBytes() / 1024), arena->NumBlockAllocations());
+	}
+	return out;
 }
@@ -7,37 +7,59 @@
 class RenderMemory
 {
 public:
+	RenderMemory();
+	~RenderMemory();
+
 	void Clear();
-		
+
 	template<typename T>
 	T *AllocMemory(int size = 1)
 	{
-		return (T*)AllocBytes(sizeof(T) * size);
+		return (T*)AllocBytes(sizeof(T) * size, alignof(T));
 	}
-		
+
+	// For data accessed with aligned SIMD loads and stores
+	template<typename T>
+	T *AllocAligned(int size, size_t alignment)
+	{
+		return (T*)AllocBytes(sizeof(T) * size, alignment > alignof(T) ? alignment : alignof(T));
+	}
+
 	template<typename T, typename... Types>
 	T *NewObject(Types &&... args)
 	{
-		void *ptr = AllocBytes(sizeof(T));
+		void *ptr = AllocBytes(sizeof(T), alignof(T));
 		return new (ptr)T(std::forward<Types>(args)...);
 	}
-		
+
+	void *AllocBytes(size_t size, size_t alignment = 16);
+
+	size_t FrameBytes() const { return UsedBytes; }
+	size_t PeakFrameBytes() const { return PeakBytes; }
+	size_t ReservedBytes() const { return Reserved; }
+	int NumBlockAllocations() const { return BlockAllocations; }
+
 private:
-	void *AllocBytes(int size);
-		
-	enum { BlockSize = 1024 * 1024 };
-		
+	// Matches the huge page size on x86 Linux
+	enum { BlockSize = 2 * 1024 * 1024 };
+
 	struct MemoryBlock
 	{
-		MemoryBlock() : Data(new uint8_t[BlockSize]), Position(0) { }
-		~MemoryBlock() { delete[] Data; }
-			
+		MemoryBlock(size_t size);
+		~MemoryBlock();
+
 		MemoryBlock(const MemoryBlock &) = delete;
 		MemoryBlock &operator=(const MemoryBlock &) = delete;
-			
+
 		uint8_t *Data;
-		uint32_t Position;
+		size_t Size;
+		size_t Position;
 	};
 	std::vector<std::unique_ptr<MemoryBlock>> UsedBlocks;
 	std::vector<std::unique_ptr<MemoryBlock>> FreeBlocks;
+
+	size_t UsedBytes = 0;	// handed out since the last Clear, including alignment padding
+	size_t PeakBytes = 0;
+	size_t Reserved = 0;
+	int BlockAllocations = 0;
 };
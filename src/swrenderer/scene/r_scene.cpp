@@ -58,6 +58,7 @@
 #include "swrenderer/r_renderthread.h"
 #include "swrenderer/things/r_playersprite.h"
 #include <chrono>
+#include <algorithm>
 
 #ifdef WIN32
 void PeekThreadedErrorPane();
@@ -67,6 +68,13 @@ EXTERN_CVAR(Int, r_clearbuffer)
 EXTERN_CVAR(Int, r_debug_draw)
 
 CVAR(Int, r_scene_multithreaded, 0, 0);
+
+// Number of screen slices per scene thread. Threads pull slices until none are left.
+CUSTOM_CVAR(Int, r_scene_slices, 4, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 1) self = 1;
+	else if (self > 32) self = 32;
+}
 CVAR(Bool, r_models, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 
 bool r_modelscene = false;
@@ -74,6 +82,15 @@ bool r_modelscene = false;
 namespace swrenderer
 {
 	cycle_t WallCycles, PlaneCycles, MaskedCycles, DrawerWaitCycles;
+
+	// Per thread busy and idle time of the last frame's scene slices, for ADD_STAT(scenethreads)
+	struct SceneThreadStat
+	{
+		double BusyMS;
+		double IdleMS;
+		int NumSlices;
+	};
+	static std::vector<SceneThreadStat> SceneThreadStats;
 	
 	RenderScene::RenderScene()
 	{
@@ -221,15 +238,18 @@ namespace swrenderer
 			StartThreads(numThreads);
 		}
 
+		SetupSlices(numThreads);
+		ThreadTimes.resize(numThreads);
+		auto sliceStart = std::chrono::steady_clock::now();
+
 		// Setup threads:
 		std::unique_lock<std::mutex> start_lock(start_mutex);
 		for (int i = 0; i < numThreads; i++)
 		{
 			*Threads[i]->Viewport = *MainThread()->Viewport;
 			*Threads[i]->Light = *MainThread()->Light;
-			Threads[i]->X1 = viewwidth * i / numThreads;
-			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
 		}
+		NextSlice = 0;
 		run_id++;
 		start_lock.unlock();
 
@@ -240,7 +260,7 @@ namespace swrenderer
 		}
 
 		// Do the main thread ourselves:
-		RenderThreadSlice(MainThread());
+		RenderThreadWork(MainThread(), 0);
 
 		// Wait for everyone to finish:
 		if (Threads.size() > 1)
@@ -260,15 +280,146 @@ namespace swrenderer
 			finished_threads = 0;
 		}
 
+		double totalMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sliceStart).count();
+		SceneThreadStats.resize(numThreads);
+		for (int i = 0; i < numThreads; i++)
+		{
+			SceneThreadStats[i].BusyMS = ThreadTimes[i].BusyMS;
+			SceneThreadStats[i].IdleMS = MAX(totalMS - ThreadTimes[i].BusyMS, 0.0);
+			SceneThreadStats[i].NumSlices = ThreadTimes[i].NumSlices;
+		}
+
 		// Change main thread back to covering the whole screen for player sprites
 		MainThread()->X1 = 0;
 		MainThread()->X2 = viewwidth;
 	}
 
-	void RenderScene::RenderThreadSlice(RenderThread *thread)
+	void RenderScene::SetupSlices(int numThreads)
 	{
+		int numSlices = (numThreads > 1) ? numThreads * r_scene_slices : 1;
+		numSlices = clamp(numSlices, 1, MAX(viewwidth / 8, 1));
+
+		CurrentLayout = &SliceLayouts[MainThread()->Viewport->RenderingToCanvas ? 1 : 0];
+		std::vector<SceneSlice> &layout = CurrentLayout->Slices;
+
+		std::vector<SceneSlice> slices(numSlices);
+		double total = 0.0;
+		if ((int)layout.size() == numSlices && CurrentLayout->ViewWidth == viewwidth)
+		{
+			for (const SceneSlice &slice : layout)
+				total += slice.Cost;
+		}
+
+		if (total <= 0.0)
+		{
+			for (int i = 0; i < numSlices; i++)
+			{
+				slices[i].X1 = viewwidth * i / numSlices;
+				slices[i].X2 = viewwidth * (i + 1) / numSlices;
+				slices[i].Predicted = 0.0;
+			}
+		}
+		else
+		{
+			// Treat the cost of each old slice as spread evenly over its columns, plus a small
+			// uniform share so that empty areas don't end up as a single slice, and split the
+			// screen into slices of equal expected cost.
+			double base = total * 0.1 / viewwidth;
+			total *= 1.1;
+
+			int x = 0;
+			double acc = 0.0;
+			size_t old = 0;
+			for (int i = 0; i < numSlices; i++)
+			{
+				slices[i].X1 = x;
+				if (i + 1 == numSlices)
+				{
+					x = viewwidth;
+				}
+				else
+				{
+					double target = total * (i + 1) / numSlices;
+					while (old + 1 < layout.size())
+					{
+						const SceneSlice &o = layout[old];
+						double end = acc + o.Cost + base * (o.X2 - o.X1);
+						if (end >= target)
+							break;
+						acc = end;
+						old++;
+					}
+					const SceneSlice &o = layout[old];
+					double density = o.Cost / (o.X2 - o.X1) + base;
+					int split = o.X1 + (int)((target - acc) / density);
+					x = clamp(split, x + 1, viewwidth - (numSlices - i - 1));
+				}
+				slices[i].X2 = x;
+			}
+
+			for (SceneSlice &slice : slices)
+			{
+				slice.Predicted = 0.0;
+				for (const SceneSlice &o : layout)
+				{
+					int overlap = MIN(slice.X2, o.X2) - MAX(slice.X1, o.X1);
+					if (overlap > 0)
+						slice.Predicted += o.Cost * overlap / (o.X2 - o.X1);
+				}
+			}
+		}
+
+		for (SceneSlice &slice : slices)
+			slice.Cost = 0.0;
+
+		layout.swap(slices);
+		CurrentLayout->ViewWidth = viewwidth;
+
+		// Hand out the most expensive slices first so that the cheap ones fill up the gaps at the end
+		SliceOrder.resize(numSlices);
+		for (int i = 0; i < numSlices; i++)
+			SliceOrder[i] = i;
+		std::stable_sort(SliceOrder.begin(), SliceOrder.end(), [&](int a, int b) { return layout[a].Predicted > layout[b].Predicted; });
+	}
+
+	void RenderScene::RenderThreadWork(RenderThread *thread, size_t index)
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		// All slices rendered by a thread go into the same queue, which is only executed once they are done
 		thread->DrawQueue->Clear();
 		thread->FrameMemory->Clear();
+
+		if (r_modelscene && thread->MainThread)
+			PolyTriangleDrawer::ClearStencil(MainThread()->DrawQueue, 0);
+
+		PolyTriangleDrawer::SetViewport(thread->DrawQueue, viewwindowx, viewwindowy, viewwidth, viewheight, thread->Viewport->RenderTarget);
+
+		int count = 0;
+		while (true)
+		{
+			int next = NextSlice++;
+			if (next >= (int)SliceOrder.size())
+				break;
+
+			SceneSlice &slice = CurrentLayout->Slices[SliceOrder[next]];
+			thread->X1 = slice.X1;
+			thread->X2 = slice.X2;
+
+			auto sliceStart = std::chrono::steady_clock::now();
+			RenderThreadSlice(thread);
+			slice.Cost = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sliceStart).count();
+			count++;
+		}
+
+		DrawerThreads::Execute(thread->DrawQueue);
+
+		ThreadTimes[index].BusyMS = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		ThreadTimes[index].NumSlices = count;
+	}
+
+	void RenderScene::RenderThreadSlice(RenderThread *thread)
+	{
 		thread->Clip3D->Cleanup();
 		thread->Clip3D->ResetClip(); // reset clips (floor/ceiling)
 		thread->Portal->CopyStackedViewParameters();
@@ -280,11 +431,6 @@ namespace swrenderer
 		thread->OpaquePass->ResetFakingUnderwater(); // [RH] Hack to make windows into underwater areas possible
 		thread->Portal->SetMainPortal();
 
-		if (r_modelscene && thread->MainThread)
-			PolyTriangleDrawer::ClearStencil(MainThread()->DrawQueue, 0);
-
-		PolyTriangleDrawer::SetViewport(thread->DrawQueue, viewwindowx, viewwindowy, viewwidth, viewheight, thread->Viewport->RenderTarget);
-
 		// Cull things outside the range seen by this thread
 		VisibleSegmentRenderer visitor;
 		if (thread->X1 > 0)
@@ -313,8 +459,6 @@ namespace swrenderer
 			if (thread->MainThread)
 				NetUpdate();
 		}
-
-		DrawerThreads::Execute(thread->DrawQueue);
 	}
 
 	void RenderScene::StartThreads(size_t numThreads)
@@ -323,6 +467,7 @@ namespace swrenderer
 		{
 			std::unique_ptr<RenderThread> thread(new RenderThread(this, false));
 			auto renderthread = thread.get();
+			size_t index = Threads.size();
 			int start_run_id = run_id;
 			thread->thread = std::thread([=]()
 			{
@@ -337,7 +482,7 @@ namespace swrenderer
 					last_run_id = run_id;
 					start_lock.unlock();
 
-					RenderThreadSlice(renderthread);
+					RenderThreadWork(renderthread, index);
 
 					// Notify main thread that we finished:
 					std::unique_lock<std::mutex> end_lock(end_mutex);
@@ -443,6 +588,18 @@ namespace swrenderer
 		return out;
 	}
 
+	ADD_STAT(scenethreads)
+	{
+		FString out;
+		out.Format("busy/idle ms (slices):");
+		for (size_t i = 0; i < SceneThreadStats.size(); i++)
+		{
+			const SceneThreadStat &stat = SceneThreadStats[i];
+			out.AppendFormat("  %d: %.1f/%.1f (%d)", (int)i, stat.BusyMS, stat.IdleMS, stat.NumSlices);
+		}
+		return out;
+	}
+
 	static double bestwallcycles = HUGE_VAL;
 
 	ADD_STAT(wallcycles)
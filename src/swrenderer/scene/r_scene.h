@@ -27,6 +27,7 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 #include "r_defs.h"
 #include "d_player.h"
 
@@ -58,7 +59,9 @@ namespace swrenderer
 	private:
 		void RenderActorView(AActor *actor, bool dontmaplines = false);
 		void RenderThreadSlices();
+		void RenderThreadWork(RenderThread *thread, size_t index);
 		void RenderThreadSlice(RenderThread *thread);
+		void SetupSlices(int numThreads);
 		void RenderPSprites();
 
 		void StartThreads(size_t numThreads);
@@ -75,5 +78,31 @@ namespace swrenderer
 		std::mutex end_mutex;
 		std::condition_variable end_condition;
 		size_t finished_threads = 0;
+
+		struct SceneSlice
+		{
+			int X1, X2;
+			double Predicted;	// cost estimated from the previous frame
+			double Cost;		// time spent on it this frame, in ms
+		};
+
+		struct SceneSliceLayout
+		{
+			std::vector<SceneSlice> Slices;	// in screen order
+			int ViewWidth = 0;
+		};
+
+		// Camera textures keep their own layout so they don't reset the main view's cost feedback
+		SceneSliceLayout SliceLayouts[2];
+		SceneSliceLayout *CurrentLayout = nullptr;
+		std::vector<int> SliceOrder;
+		std::atomic<int> NextSlice;
+
+		struct SceneThreadTime
+		{
+			double BusyMS = 0.0;
+			int NumSlices = 0;
+		};
+		std::vector<SceneThreadTime> ThreadTimes;
 	};
 }
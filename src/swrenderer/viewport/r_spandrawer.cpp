@@ -51,6 +51,17 @@ namespace swrenderer
 		ds_source_mipmapped = tex->Mipmapped() && tex->GetPhysicalWidth() > 1 && tex->GetPhysicalHeight() > 1;
 	}
 
+	// Unmipmapped truecolor texture that does not come from the texture manager (drawerbench)
+	void SpanDrawerArgs::SetTexture(const uint32_t *bgrapixels, int width, int height)
+	{
+		ds_texwidth = width;
+		ds_texheight = height;
+		for (ds_xbits = 0; (2 << ds_xbits) <= width; ds_xbits++);
+		for (ds_ybits = 0; (2 << ds_ybits) <= height; ds_ybits++);
+		ds_source = (const uint8_t*)bgrapixels;
+		ds_source_mipmapped = false;
+	}
+
 	void SpanDrawerArgs::SetStyle(bool masked, bool additive, fixed_t alpha, FDynamicColormap *basecolormap)
 	{
 		if (masked)
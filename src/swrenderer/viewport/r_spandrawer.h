@@ -20,6 +20,7 @@ namespace swrenderer
 		void SetDestX1(int x) { ds_x1 = x; }
 		void SetDestX2(int x) { ds_x2 = x; }
 		void SetTexture(RenderThread *thread, FSoftwareTexture *tex);
+		void SetTexture(const uint32_t *bgrapixels, int width, int height);
 		void SetTextureLOD(double lod) { ds_lod = lod; }
 		void SetTextureUPos(double u) { ds_xfrac = (uint32_t)(int64_t)(u * 4294967296.0); }
 		void SetTextureVPos(double v) { ds_yfrac = (uint32_t)(int64_t)(v * 4294967296.0); }
@@ -42,6 +42,11 @@ namespace swrenderer
 		(thread->Drawers(dc_viewport)->*wallfunc)(*this);
 	}
 
+	bool WallDrawerArgs::IsOpaqueColumn() const
+	{
+		return wallfunc == &SWPixelFormatDrawers::DrawWallColumn;
+	}
+
 	void WallDrawerArgs::SetStyle(bool masked, bool additive, fixed_t alpha, FDynamicColormap *basecolormap)
 	{
 		if (alpha < OPAQUE || additive)
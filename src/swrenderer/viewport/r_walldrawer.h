@@ -58,6 +58,9 @@ namespace swrenderer
 
 		RenderViewport *Viewport() const { return dc_viewport; }
 
+		// True if the style uses the plain opaque wall drawer
+		bool IsOpaqueColumn() const;
+
 	private:
 		uint8_t *dc_dest = nullptr;
 		int dc_dest_y = 0;
@@ -81,4 +84,26 @@ namespace swrenderer
 
 		RenderViewport *dc_viewport = nullptr;
 	};
+
+	// Adjacent opaque paletted wall columns drawn by one command, a row at a time
+	class WallColumnBatch
+	{
+	public:
+		enum { MaxColumns = 4 };
+
+		struct Column
+		{
+			const uint8_t *source;
+			const uint8_t *colormap;
+			uint32_t texturefrac;
+			uint32_t iscale;
+			int y1, y2;
+		};
+
+		Column columns[MaxColumns];
+		int count = 0;
+		uint8_t *dest = nullptr;	// top of the view for the first column
+		int pitch = 0;
+		int fracbits = 0;
+	};
 }
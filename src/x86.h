@@ -37,7 +37,10 @@ struct CPUInfo	// 92 bytes
 			uint32_t DontCare1a:9;
 			uint32_t bSSE41:1;
 			uint32_t bSSE42:1;
-			uint32_t DontCare2a:11;
+			uint32_t DontCare2a:6;
+			uint32_t bOSXSAVE:1;
+			uint32_t bAVX:1;
+			uint32_t DontCare2b:3;
 
 			uint32_t bFPU:1;
 			uint32_t bVME:1;
@@ -98,6 +101,9 @@ struct CPUInfo	// 92 bytes
 		};
 		uint32_t AMD_DataL1Info;
 	};
+
+	// Only set if the OS also saves the YMM registers
+	uint8_t bAVX2;
 };
 
 